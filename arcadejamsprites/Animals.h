@@ -2,16 +2,19 @@
 
 #include "pch.h"
 #include "Descriptors.h"
+#include "Components.h"
 
 using namespace DirectX;
 using namespace DirectX::SimpleMath;
 
 constexpr int DOG_HP = 3;
 
+// Crab and octopus positions live in their Herd's packed arrays and are moved by the
+// herd's behavior, so an Animal itself only carries the state behaviors don't touch
 class Animal {
 public:
 	boolean alive;
-	Vector2 pos;
+	Entity id = NULL_ENTITY;
 	Descriptors type = Crab;
 	RECT rect = { 0, 0, 32, 32 };
 	
@@ -19,41 +22,16 @@ public:
 		alive = true;
 	}
 
-	Animal(Vector2 pos2) {
-		alive = true;
-		pos = pos2;
-	}
-
-	void update() {
-		if (alive == false) {
-			delete this;
-		}
-
-		pos.y += static_cast<float>(cos(pos.x) * 2.f);
-	}
-
 	void smush() {
 		alive = false;
 	}
 };
 
 
-class Octoc : public Animal {
-public:
-	Octoc() {
-		type = Octo;
-		pos = Vector2(-499.f, 0.f);
-	}
-
-	void update(const float& tt, Vector2 const projPos) {
-		pos.y = projPos.y;
-	}
-
-};
-
 class Dog : public Animal {
 public:
 	int hp = DOG_HP;
+	Vector2 pos;
 	Vector2 velocity;
 
 	Dog() {
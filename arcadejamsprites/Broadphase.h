@@ -0,0 +1,138 @@
+#pragma once
+
+#include "pch.h"
+#include "GridMath.h"
+#include <vector>
+
+using namespace DirectX::SimpleMath;
+
+// world units per broadphase cell, at least twice a hitbox so a query touches at most 2x2 cells
+constexpr float BROADPHASE_CELL = 128.f;
+
+// most distinct buckets a query walks; a query over more cells than this visits every entity
+constexpr int BROADPHASE_QUERY_BUCKETS = 16;
+
+// A query box and an entity whose cell it touches, still to be tested exactly
+struct CandidatePair {
+    uint32_t query;
+    uint32_t entity;
+};
+
+// Uniform grid over entity positions, rebuilt every tick.
+// Cells are hashed into a power of two bucket table sized from the entity count, so the grid
+// covers an unbounded world in O(N) memory. Entities are counting-sorted by bucket into one
+// index array, and a query walks only the buckets of the cells its box can overlap.
+// Boxes are [pos, pos + size) on both axes, matching World::checkForCollision; a sweep covers
+// the box at both ends of its move and everything between.
+class Broadphase {
+public:
+    void build(const float* x, const float* y, const size_t count) {
+        size_t buckets = 16;
+        while (buckets < count * 2) {
+            buckets *= 2;
+        }
+        mask = static_cast<uint32_t>(buckets - 1);
+
+        bucketStart.assign(buckets + 1, 0);
+        bucketOf.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            bucketOf[i] = bucket(cell(x[i]), cell(y[i]));
+            ++bucketStart[bucketOf[i] + 1];
+        }
+        for (size_t b = 0; b < buckets; ++b) {
+            bucketStart[b + 1] += bucketStart[b];
+        }
+
+        // fill each bucket from its start, then shift the starts back
+        entities.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            entities[bucketStart[bucketOf[i]]++] = static_cast<uint32_t>(i);
+        }
+        for (size_t b = buckets; b > 0; --b) {
+            bucketStart[b] = bucketStart[b - 1];
+        }
+        bucketStart[0] = 0;
+    }
+
+    // visit(entity) for every entity in a cell a size box at pos could overlap.
+    // Each entity is visited at most once; hash collisions only add candidates.
+    // With size at most BROADPHASE_CELL / 2 the box spans no more than 2x2 cells.
+    template <typename TVisit>
+    void query(const Vector2 pos, const float size, const TVisit& visit) const {
+        // entity boxes start up to size before the query box
+        query(pos - Vector2(size, size), pos + Vector2(size, size), visit);
+    }
+
+    // visit(entity) for every entity positioned in a cell overlapping [min, max], each at most once
+    template <typename TVisit>
+    void query(const Vector2 min, const Vector2 max, const TVisit& visit) const {
+        if (entities.empty()) {
+            return;
+        }
+
+        const int cx0 = cell(min.x);
+        const int cx1 = cell(max.x);
+        const int cy0 = cell(min.y);
+        const int cy1 = cell(max.y);
+
+        // a long sweep covers more cells than are worth deduplicating, take everyone
+        const int64_t cells = (static_cast<int64_t>(cx1) - cx0 + 1) * (static_cast<int64_t>(cy1) - cy0 + 1);
+        if (cells > BROADPHASE_QUERY_BUCKETS) {
+            for (const uint32_t entity : entities) {
+                visit(entity);
+            }
+            return;
+        }
+
+        uint32_t seen[BROADPHASE_QUERY_BUCKETS];
+        int seenCount = 0;
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                const uint32_t b = bucket(cx, cy);
+                if (std::find(seen, seen + seenCount, b) != seen + seenCount) {
+                    continue;
+                }
+                seen[seenCount++] = b;
+                for (uint32_t k = bucketStart[b]; k < bucketStart[b + 1]; ++k) {
+                    visit(entities[k]);
+                }
+            }
+        }
+    }
+
+    // Candidate pairs for a batch of query boxes, appended to out
+    void pairs(const Vector2* queries, const size_t count, const float size, std::vector<CandidatePair>& out) const {
+        for (size_t q = 0; q < count; ++q) {
+            query(queries[q], size, [&](const uint32_t entity) {
+                out.push_back(CandidatePair{ static_cast<uint32_t>(q), entity });
+            });
+        }
+    }
+
+    // Candidate pairs for a batch of size boxes each moving from (fromX, fromY) to (toX, toY),
+    // covering every entity the box could overlap anywhere along the way
+    void sweeps(const float* fromX, const float* fromY, const float* toX, const float* toY,
+        const size_t count, const float size, std::vector<CandidatePair>& out) const {
+        for (size_t q = 0; q < count; ++q) {
+            const Vector2 min(std::min(fromX[q], toX[q]) - size, std::min(fromY[q], toY[q]) - size);
+            const Vector2 max(std::max(fromX[q], toX[q]) + size, std::max(fromY[q], toY[q]) + size);
+            query(min, max, [&](const uint32_t entity) {
+                out.push_back(CandidatePair{ static_cast<uint32_t>(q), entity });
+            });
+        }
+    }
+
+private:
+    static int cell(const float v) {
+        return static_cast<int>(std::floor(v * (1.f / BROADPHASE_CELL)));
+    }
+
+    uint32_t bucket(const int cx, const int cy) const {
+        return hashCell(cx, cy) & mask;
+    }
+
+    uint32_t mask = 0;
+    std::vector<uint32_t> bucketStart;
+    std::vector<uint32_t> bucketOf;
+    std::vector<uint32_t> entities;
+};
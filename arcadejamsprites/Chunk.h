@@ -0,0 +1,90 @@
+#pragma once
+
+#include "pch.h"
+#include "Descriptors.h"
+#include "ChunkManager.h"
+#include "TileMask.h"
+#include <array>
+
+using namespace DirectX::SimpleMath;
+
+// Tile attribute bitmaps kept per chunk
+enum TileLayer {
+    SolidLayer,
+    WaterLayer,
+    WalkableLayer,
+    LayerCount,
+};
+
+// Width x Height block of tiles, row major, palette compressed.
+// Dimensions are compile time constants so per-chunk loops have fixed trip counts.
+// Tile positions follow from the index and the atlas rect from the descriptor, so a tile
+// is a single byte, and a chunk of one tile type keeps only its palette entry.
+template <int Width, int Height>
+struct Chunk {
+    static constexpr int Columns = Width;
+    static constexpr int Rows = Height;
+    static constexpr int Tiles = Width * Height;
+
+    typedef TileMask<Width, Height> Mask;
+
+    static constexpr int index(const int column, const int row) {
+        return row * Width + column;
+    }
+
+    static constexpr int columnOf(const int index) {
+        return index % Width;
+    }
+
+    static constexpr int rowOf(const int index) {
+        return index / Width;
+    }
+
+    // Chunk-local cell to global tile cell
+    static constexpr int globalColumn(const ChunkCoord coord, const int column) {
+        return coord.x * Width + column;
+    }
+
+    static constexpr int globalRow(const ChunkCoord coord, const int row) {
+        return coord.y * Height + row;
+    }
+
+    typedef std::array<uint8_t, Tiles> TileArray;
+
+    ChunkCoord coord = { 0, 0 };
+
+    // One byte Descriptors per tile, read only while mixed, otherwise every tile is the palette entry.
+    // Once allocated the array stays with the chunk's storage through every recycle.
+    std::unique_ptr<TileArray> types;
+    bool mixed = false;
+    uint8_t palette = Sand;
+
+    std::array<Mask, LayerCount> layers;
+
+    Descriptors type(const int index) const {
+        return static_cast<Descriptors>(mixed ? (*types)[index] : palette);
+    }
+
+    bool uniform() const {
+        return !mixed;
+    }
+
+    // Every tile becomes desc, the tile array is kept for the next mixed chunk this storage holds
+    void setUniform(const Descriptors desc) {
+        mixed = false;
+        palette = static_cast<uint8_t>(desc);
+    }
+
+    // Per-tile storage for a mixed chunk, allocated the first time this storage needs it
+    TileArray& tiles() {
+        if (!types) {
+            types = std::make_unique<TileArray>();
+        }
+        mixed = true;
+        return *types;
+    }
+
+    size_t bytes() const {
+        return sizeof(Chunk) + (types ? sizeof(TileArray) : 0);
+    }
+};
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "pch.h"
+#include "Chunk.h"
+#include "GridMath.h"
+#include "MappedFile.h"
+#include <mutex>
+
+// chunks the cache file can hold before it stops taking new ones
+constexpr uint32_t CHUNK_CACHE_CAPACITY = 4096;
+
+// On-disk cache of generated chunks, memory mapped for its whole lifetime.
+//
+// Layout, all fixed size so nothing is parsed on load:
+//   Header
+//   IndexEntry[CHUNK_CACHE_CAPACITY * 2]   open addressed hash of chunk coordinate -> record
+//   Record[CHUNK_CACHE_CAPACITY]           layer bitmaps and tile bytes, appended in store order
+//
+// A file written for a different seed or chunk size is wiped on open. If the file can't be
+// opened or mapped the cache stays closed and every load misses, the game just generates.
+// Records are checked before use, so one torn by a crash mid-store is a miss too.
+// TFile supplies the mapping, anything with MappedFile's open and close will do.
+template <typename TChunk, typename TFile = MappedFile>
+class ChunkCache {
+public:
+    ChunkCache() = default;
+
+    ~ChunkCache() {
+        close();
+    }
+
+    ChunkCache(const ChunkCache&) = delete;
+    ChunkCache& operator=(const ChunkCache&) = delete;
+
+    bool open(const wchar_t* path, const uint32_t seed) {
+        close();
+
+        view = file.open(path, FileBytes);
+        if (!view) {
+            return false;
+        }
+
+        header = reinterpret_cast<Header*>(view);
+        index = reinterpret_cast<IndexEntry*>(view + sizeof(Header));
+        records = reinterpret_cast<Record*>(view + sizeof(Header) + sizeof(IndexEntry) * IndexSlots);
+
+        if (header->magic != Magic || header->version != Version || header->seed != seed ||
+            header->columns != static_cast<uint32_t>(TChunk::Columns) || header->rows != static_cast<uint32_t>(TChunk::Rows) ||
+            header->capacity != CHUNK_CACHE_CAPACITY || header->count > CHUNK_CACHE_CAPACITY) {
+            std::memset(view, 0, sizeof(Header) + sizeof(IndexEntry) * IndexSlots);
+            header->magic = Magic;
+            header->version = Version;
+            header->seed = seed;
+            header->columns = TChunk::Columns;
+            header->rows = TChunk::Rows;
+            header->capacity = CHUNK_CACHE_CAPACITY;
+            header->count = 0;
+        }
+        return true;
+    }
+
+    void close() {
+        file.close();
+        view = nullptr;
+        header = nullptr;
+        index = nullptr;
+        records = nullptr;
+    }
+
+    bool isOpen() const {
+        return view != nullptr;
+    }
+
+    uint32_t count() const {
+        return header ? header->count : 0;
+    }
+
+    // Copy a cached chunk straight out of the mapping into recycled storage
+    bool load(TChunk& chunk, const ChunkCoord coord) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!view) {
+            return false;
+        }
+
+        const IndexEntry* entry = probe(coord);
+        if (!entry || !entry->record || entry->record - 1 >= header->count) {
+            return false;
+        }
+
+        const Record& record = records[entry->record - 1];
+        if (!intact(record)) {
+            return false;
+        }
+        chunk.coord = coord;
+        for (int layer = 0; layer < LayerCount; ++layer) {
+            std::memcpy(chunk.layers[layer].rows.data(), record.layers[layer], sizeof(record.layers[layer]));
+        }
+        if (record.uniform) {
+            chunk.setUniform(static_cast<Descriptors>(record.palette));
+        }
+        else {
+            std::memcpy(chunk.tiles().data(), record.tiles, sizeof(record.tiles));
+        }
+        return true;
+    }
+
+    // Write a chunk unless it is already cached or the file is full.
+    // Chunks are a pure function of seed and coordinate, so a cached record never goes stale.
+    void store(const TChunk& chunk) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!view || header->count >= CHUNK_CACHE_CAPACITY) {
+            return;
+        }
+
+        IndexEntry* entry = probe(chunk.coord);
+        if (!entry || entry->record) {
+            return;
+        }
+
+        Record& record = records[header->count];
+        for (int layer = 0; layer < LayerCount; ++layer) {
+            std::memcpy(record.layers[layer], chunk.layers[layer].rows.data(), sizeof(record.layers[layer]));
+        }
+        record.uniform = chunk.uniform() ? 1 : 0;
+        record.palette = chunk.palette;
+        if (!chunk.uniform()) {
+            std::memcpy(record.tiles, chunk.types->data(), sizeof(record.tiles));
+        }
+
+        entry->x = chunk.coord.x;
+        entry->y = chunk.coord.y;
+        entry->record = ++header->count;
+    }
+
+private:
+    static constexpr uint32_t Magic = 0x43465552; // "RUFC"
+    static constexpr uint32_t Version = 1;
+    static constexpr uint32_t IndexSlots = CHUNK_CACHE_CAPACITY * 2;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t seed;
+        uint32_t columns;
+        uint32_t rows;
+        uint32_t capacity;
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    struct IndexEntry {
+        int32_t x;
+        int32_t y;
+        uint32_t record; // 1-based, 0 marks an empty slot
+    };
+
+    struct Record {
+        uint64_t layers[LayerCount][TChunk::Rows];
+        uint8_t uniform;
+        uint8_t palette;
+        uint8_t tiles[TChunk::Tiles];
+    };
+
+    static constexpr size_t FileBytes = sizeof(Header) + sizeof(IndexEntry) * IndexSlots + sizeof(Record) * CHUNK_CACHE_CAPACITY;
+
+    // hashCell rather than std::hash so the file reads back the same from any build
+    static uint32_t slotOf(const ChunkCoord coord) {
+        return hashCell(coord.x, coord.y) & (IndexSlots - 1);
+    }
+
+    // Slot holding coord, or the empty slot it would go in. The index is never more than
+    // half full, so there is always an empty slot to stop at unless the file is damaged,
+    // in which case after one lap this gives up with nullptr.
+    IndexEntry* probe(const ChunkCoord coord) const {
+        uint32_t slot = slotOf(coord);
+        for (uint32_t probes = 0; probes < IndexSlots; ++probes) {
+            IndexEntry* entry = &index[slot];
+            if (!entry->record || (entry->x == coord.x && entry->y == coord.y)) {
+                return entry;
+            }
+            slot = (slot + 1) & (IndexSlots - 1);
+        }
+        return nullptr;
+    }
+
+    // Every tile type the record would hand out indexes TILE_RECTS, so each must be a Descriptors value
+    static bool intact(const Record& record) {
+        if (record.uniform) {
+            return record.palette < Descriptors::Count;
+        }
+        for (const uint8_t type : record.tiles) {
+            if (type >= Descriptors::Count) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    TFile file;
+    uint8_t* view = nullptr;
+
+    Header* header = nullptr;
+    IndexEntry* index = nullptr;
+    Record* records = nullptr;
+
+    // taken by the chunk worker's loads and the main thread's stores
+    std::mutex mutex;
+};
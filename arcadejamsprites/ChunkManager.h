@@ -0,0 +1,313 @@
+#pragma once
+
+#include "pch.h"
+#include "SpscQueue.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Integer chunk coordinate, one unit per CHUNK_WIDTH x CHUNK_HEIGHT block of tiles
+struct ChunkCoord {
+    int x;
+    int y;
+
+    bool operator==(const ChunkCoord& other) const {
+        return x == other.x && y == other.y;
+    }
+
+    bool operator!=(const ChunkCoord& other) const {
+        return !(*this == other);
+    }
+};
+
+struct ChunkCoordHash {
+    size_t operator()(const ChunkCoord& c) const {
+        return std::hash<uint64_t>()((static_cast<uint64_t>(static_cast<uint32_t>(c.x)) << 32) | static_cast<uint32_t>(c.y));
+    }
+};
+
+// Where a ChunkManager builds its chunks.
+// Background generation keeps chunk building off the calling thread, but which streamAround
+// a chunk arrives in depends on how the worker was scheduled. Inline builds every missing chunk
+// of the window and lookahead band inside streamAround, so the same sequence of calls always
+// admits the same chunks at the same calls, which headless replays depend on.
+enum class ChunkGeneration {
+    Background,
+    Inline,
+};
+
+// Keeps a fixed window of chunks resident around a center chunk.
+// Chunks that leave the window are parked on a free list and their storage
+// is handed to the next chunk generated, so memory stays flat however far the camera travels.
+//
+// Generation runs on a worker thread unless it is Inline. The window plus one band of chunks ahead of the
+// heading are requested early and the finished chunks come back through a lock-free ring,
+// so crossing a chunk boundary never generates on the calling thread. Only the very first
+// window, or a center chunk that was never requested (e.g. after a teleport), is built inline.
+//
+// TChunk must provide bytes() reporting its footprint. The generator must be safe to call
+// from the worker thread and give the same chunk for the same coordinate.
+template <typename TChunk>
+class ChunkManager {
+public:
+    typedef std::function<void(TChunk&, ChunkCoord)> Generator;
+    typedef std::function<void(const TChunk&)> Evictor;
+    typedef std::function<void(const TChunk&)> Admitter;
+
+    // evict, if set, sees each chunk on the calling thread just before its storage is recycled.
+    // admit, if set, sees each chunk on the calling thread once it is resident and survived eviction.
+    ChunkManager(int radiusX, int radiusY, Generator generate, Evictor evict = nullptr, Admitter admit = nullptr,
+        ChunkGeneration generation = ChunkGeneration::Background) :
+        radiusX(radiusX),
+        radiusY(radiusY),
+        generate(generate),
+        evict(evict),
+        admit(admit),
+        generation(generation)
+    {
+        resident.reserve(2 * windowSize());
+        pending.reserve(QueueSize);
+        arrived.reserve(2 * windowSize());
+        freeChunks.reserve(2 * windowSize());
+        if (generation == ChunkGeneration::Background) {
+            worker = std::thread([this] { work(); });
+        }
+    }
+
+    ~ChunkManager() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (worker.joinable()) {
+            worker.join();
+        }
+
+        // chunks still in flight are owned by the queues
+        Job job;
+        while (requests.pop(job)) {
+            delete job.chunk;
+        }
+        while (finished.pop(job)) {
+            delete job.chunk;
+        }
+    }
+
+    ChunkManager(const ChunkManager&) = delete;
+    ChunkManager& operator=(const ChunkManager&) = delete;
+
+    // Publish finished chunks, evict chunks outside the window and its lookahead band,
+    // and request the missing ones. heading is the direction of travel, -1, 0 or 1 per axis.
+    void streamAround(const ChunkCoord center, const ChunkCoord heading) {
+        collect();
+
+        const ChunkCoord ahead{ center.x + heading.x, center.y + heading.y };
+        const bool firstWindow = resident.empty() && pending.empty();
+
+        // evict chunks left behind
+        for (auto it = resident.begin(); it != resident.end();) {
+            if (!inWindow(it->first, center) && !inWindow(it->first, ahead)) {
+                if (evict) {
+                    evict(*it->second);
+                }
+                freeChunks.push_back(std::move(it->second));
+                it = resident.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        if (generation == ChunkGeneration::Inline) {
+            buildWindow(center);
+            buildWindow(ahead);
+        }
+        // the camera's own chunk can't wait for the worker
+        else if (firstWindow || !isKnown(center)) {
+            for (int y = center.y - radiusY; y <= center.y + radiusY; ++y) {
+                for (int x = center.x - radiusX; x <= center.x + radiusX; ++x) {
+                    const ChunkCoord coord{ x, y };
+                    if ((firstWindow || coord == center) && !isKnown(coord)) {
+                        std::unique_ptr<TChunk> chunk = acquire();
+                        generate(*chunk, coord);
+                        arrived.push_back(coord);
+                        resident.emplace(coord, std::move(chunk));
+                    }
+                }
+            }
+        }
+
+        // chunks collected above that were evicted straight away are never admitted
+        for (const ChunkCoord coord : arrived) {
+            const TChunk* chunk = find(coord);
+            if (admit && chunk) {
+                admit(*chunk);
+            }
+        }
+        arrived.clear();
+
+        if (generation == ChunkGeneration::Background) {
+            requestWindow(center);
+            requestWindow(ahead);
+        }
+    }
+
+    const TChunk* find(const ChunkCoord coord) const {
+        auto it = resident.find(coord);
+        return it == resident.end() ? nullptr : it->second.get();
+    }
+
+    template <typename TVisit>
+    void forEach(const TVisit& visit) const {
+        for (const auto& entry : resident) {
+            visit(*entry.second);
+        }
+    }
+
+    size_t residentCount() const {
+        return resident.size();
+    }
+
+    // Bytes held by resident chunks, not counting the recycled ones on the free list
+    size_t residentBytes() const {
+        size_t total = 0;
+        for (const auto& entry : resident) {
+            total += entry.second->bytes();
+        }
+        return total;
+    }
+
+private:
+    static constexpr size_t QueueSize = 32;
+
+    // A chunk in flight; the queue holding it owns the storage
+    struct Job {
+        ChunkCoord coord;
+        TChunk* chunk;
+    };
+
+    size_t windowSize() const {
+        return static_cast<size_t>((2 * radiusX + 1) * (2 * radiusY + 1));
+    }
+
+    bool inWindow(const ChunkCoord coord, const ChunkCoord center) const {
+        return std::abs(coord.x - center.x) <= radiusX && std::abs(coord.y - center.y) <= radiusY;
+    }
+
+    bool isKnown(const ChunkCoord coord) const {
+        return resident.find(coord) != resident.end() || pending.find(coord) != pending.end();
+    }
+
+    // Generate every missing chunk of the window around center on the calling thread
+    void buildWindow(const ChunkCoord center) {
+        for (int y = center.y - radiusY; y <= center.y + radiusY; ++y) {
+            for (int x = center.x - radiusX; x <= center.x + radiusX; ++x) {
+                const ChunkCoord coord{ x, y };
+                if (!isKnown(coord)) {
+                    std::unique_ptr<TChunk> chunk = acquire();
+                    generate(*chunk, coord);
+                    arrived.push_back(coord);
+                    resident.emplace(coord, std::move(chunk));
+                }
+            }
+        }
+    }
+
+    void requestWindow(const ChunkCoord center) {
+        bool requested = false;
+        for (int y = center.y - radiusY; y <= center.y + radiusY; ++y) {
+            for (int x = center.x - radiusX; x <= center.x + radiusX; ++x) {
+                const ChunkCoord coord{ x, y };
+                if (isKnown(coord) || pending.size() >= QueueSize) {
+                    continue;
+                }
+
+                Job job{ coord, acquire().release() };
+                if (!requests.push(job)) {
+                    freeChunks.emplace_back(job.chunk);
+                    continue;
+                }
+                pending.insert(coord);
+                requested = true;
+            }
+        }
+
+        if (requested) {
+            // empty critical section so the worker can't miss the wakeup between its check and its wait
+            { std::lock_guard<std::mutex> lock(wakeMutex); }
+            wake.notify_one();
+        }
+    }
+
+    // Move chunks the worker has finished into the resident set
+    void collect() {
+        Job job;
+        while (finished.pop(job)) {
+            std::unique_ptr<TChunk> chunk(job.chunk);
+            pending.erase(job.coord);
+            if (resident.find(job.coord) == resident.end()) {
+                arrived.push_back(job.coord);
+                resident.emplace(job.coord, std::move(chunk));
+            }
+            else {
+                // built inline while this one was in flight
+                freeChunks.push_back(std::move(chunk));
+            }
+        }
+    }
+
+    void work() {
+        Job job;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wake.wait(lock, [this] { return stopping || !requests.empty(); });
+                if (stopping) {
+                    return;
+                }
+            }
+
+            while (requests.pop(job)) {
+                generate(*job.chunk, job.coord);
+                // pending is capped at QueueSize, so there is always room
+                finished.push(job);
+            }
+        }
+    }
+
+    std::unique_ptr<TChunk> acquire() {
+        if (freeChunks.empty()) {
+            return std::make_unique<TChunk>();
+        }
+        std::unique_ptr<TChunk> chunk = std::move(freeChunks.back());
+        freeChunks.pop_back();
+        return chunk;
+    }
+
+    int radiusX;
+    int radiusY;
+    Generator generate;
+    Evictor evict;
+    Admitter admit;
+    ChunkGeneration generation;
+
+    std::unordered_map<ChunkCoord, std::unique_ptr<TChunk>, ChunkCoordHash> resident;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> pending;
+    std::vector<std::unique_ptr<TChunk>> freeChunks;
+
+    // chunks made resident during the current streamAround, waiting for admit
+    std::vector<ChunkCoord> arrived;
+
+    // main thread -> worker, worker -> main thread
+    SpscQueue<Job, QueueSize> requests;
+    SpscQueue<Job, QueueSize> finished;
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread worker;
+};
@@ -1,14 +1,42 @@
 #pragma once
 #include "pch.h"
 using namespace DirectX::SimpleMath;
-#include <unordered_map>
+#include <cstdint>
+#include <vector>
 
 
-// not yet in use, should be in a different branch
+// entity handle layout: low bits index a registry slot, the rest are that slot's generation
+constexpr uint32_t ENTITY_INDEX_BITS = 20;
+constexpr uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+constexpr uint32_t ENTITY_GENERATION_MASK = (1u << (32 - ENTITY_INDEX_BITS)) - 1;
+
+// end of the Entities free list
+constexpr uint32_t ENTITY_NO_SLOT = UINT32_MAX;
+
+// 32-bit index + generation handle handed out by Entities.
+// Generations start at 1, so a zero handle never refers to anything.
 struct Entity {
-	__int32 id;
+	uint32_t id;
+
+	uint32_t index() const {
+		return id & ENTITY_INDEX_MASK;
+	}
+
+	uint32_t generation() const {
+		return id >> ENTITY_INDEX_BITS;
+	}
+
+	bool operator==(const Entity other) const {
+		return id == other.id;
+	}
+
+	bool operator!=(const Entity other) const {
+		return id != other.id;
+	}
 };
 
+constexpr Entity NULL_ENTITY = { 0 };
+
 struct AABB {
 	int width;
 	int height;
@@ -20,27 +48,108 @@ public:
 	System();
 };
 
-class Position : public System {
+// Sparse set of T keyed by entity.
+// sparse maps an entity index to its slot in the packed arrays, dense and values hold the entities
+// and their components back to back, so walking a component is a linear walk of memory.
+// add, remove, has and get are O(1); remove swaps the last element into the hole.
+// Lookups compare the whole handle, so a stale handle to a reused index finds nothing.
+template <typename T>
+class ComponentStore {
 public:
+	// Add or overwrite e's component
+	T& add(const Entity e, const T& value) {
+		const uint32_t key = keyOf(e);
+		if (key >= sparse.size()) {
+			sparse.resize(key + 1, static_cast<uint32_t>(Absent));
+		}
+		if (sparse[key] != Absent) {
+			dense[sparse[key]] = e;
+			return values[sparse[key]] = value;
+		}
+		sparse[key] = static_cast<uint32_t>(dense.size());
+		dense.push_back(e);
+		values.push_back(value);
+		return values.back();
+	}
+
+	void remove(const Entity e) {
+		if (!has(e)) {
+			return;
+		}
+		const uint32_t key = keyOf(e);
+		const uint32_t slot = sparse[key];
+		const uint32_t last = static_cast<uint32_t>(dense.size() - 1);
+		if (slot != last) {
+			dense[slot] = dense[last];
+			values[slot] = std::move(values[last]);
+			sparse[keyOf(dense[slot])] = slot;
+		}
+		dense.pop_back();
+		values.pop_back();
+		sparse[key] = Absent;
+	}
+
+	bool has(const Entity e) const {
+		const uint32_t key = keyOf(e);
+		return key < sparse.size() && sparse[key] != Absent && dense[sparse[key]] == e;
+	}
+
+	// e's component, nullptr if it has none
+	T* get(const Entity e) {
+		return has(e) ? &values[sparse[keyOf(e)]] : nullptr;
+	}
+
+	const T* get(const Entity e) const {
+		return has(e) ? &values[sparse[keyOf(e)]] : nullptr;
+	}
 
-	Vector3 Get(__int32 entityId) {
-		return entities.at(entityId);
+	void clear() {
+		sparse.clear();
+		dense.clear();
+		values.clear();
 	}
 
-	void Add(Entity& e) {
-		entityIds.push_back(e.id);
+	void reserve(const size_t count) {
+		dense.reserve(count);
+		values.reserve(count);
 	}
 
-	void Add(const Entity e, const Vector3 pos) {
-		entityIds.push_back(e.id);
-		entities.insert({ e.id, pos });
+	size_t size() const {
+		return dense.size();
+	}
+
+	// Packed arrays, entity(i) owns component(i)
+	T* data() {
+		return values.data();
+	}
+
+	const Entity* entities() const {
+		return dense.data();
+	}
+
+	// fn(Entity, T&) for every component in packed order
+	template <typename TFunction>
+	void each(const TFunction& fn) {
+		for (size_t i = 0; i < dense.size(); ++i) {
+			fn(dense[i], values[i]);
+		}
 	}
 
 private:
-	std::vector<__int32> entityIds;
-	std::unordered_map<__int32, Vector3> entities;
+	static constexpr uint32_t Absent = UINT32_MAX;
+
+	static uint32_t keyOf(const Entity e) {
+		return e.index();
+	}
+
+	std::vector<uint32_t> sparse;
+	std::vector<Entity> dense;
+	std::vector<T> values;
 };
 
+// World position of every entity that has one
+typedef ComponentStore<Vector3> Position;
+
 class Projectile : public System {
 public:
 	void Update() {
@@ -48,10 +157,62 @@ public:
 	}
 };
 
-struct Entities {
-	std::unordered_map<__int32, Entity> entities;
+// Entity registry. Handles come from a LIFO free list of slot indices; destroying an entity
+// bumps its slot's generation, so every handle still pointing at it stops validating.
+// create, destroy and valid are O(1) array operations and never throw.
+class Entities {
+public:
+	void reserve(const size_t count) {
+		generations.reserve(count);
+		nextFree.reserve(count);
+	}
+
+	// New handle, NULL_ENTITY once every index is taken
+	Entity create() {
+		uint32_t index;
+		if (freeHead != ENTITY_NO_SLOT) {
+			index = freeHead;
+			freeHead = nextFree[index];
+		}
+		else {
+			index = static_cast<uint32_t>(generations.size());
+			if (index > ENTITY_INDEX_MASK) {
+				return NULL_ENTITY;
+			}
+			generations.push_back(1);
+			nextFree.push_back(ENTITY_NO_SLOT);
+		}
+		++liveCount;
+		return Entity{ generations[index] << ENTITY_INDEX_BITS | index };
+	}
+
+	void destroy(const Entity e) {
+		if (!valid(e)) {
+			return;
+		}
+		const uint32_t index = e.index();
+		// skip generation 0 on wrap so NULL_ENTITY stays invalid
+		generations[index] = (generations[index] + 1) & ENTITY_GENERATION_MASK;
+		if (generations[index] == 0) {
+			generations[index] = 1;
+		}
+		nextFree[index] = freeHead;
+		freeHead = index;
+		--liveCount;
+	}
+
+	bool valid(const Entity e) const {
+		const uint32_t index = e.index();
+		return e.id != 0 && index < generations.size() && generations[index] == e.generation();
+	}
 
-	Entity getEntity(__int32 id) {
-		return entities.at(id);
+	uint32_t live() const {
+		return liveCount;
 	}
+
+private:
+	std::vector<uint32_t> generations;
+	std::vector<uint32_t> nextFree;
+	uint32_t freeHead = ENTITY_NO_SLOT;
+	uint32_t liveCount = 0;
 };
\ No newline at end of file
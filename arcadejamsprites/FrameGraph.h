@@ -0,0 +1,165 @@
+#pragma once
+
+#include "pch.h"
+#include "Jobs.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+// most stages a frame graph can hold
+constexpr size_t FRAME_GRAPH_MAX_STAGES = 32;
+
+// Stages of a tick as a dependency graph.
+// Each stage declares the state it reads and writes as bits of a caller defined mask. A stage
+// runs after every earlier-added stage it conflicts with, i.e. one writing what it touches or
+// reading what it writes, so the graph gives the same results as running the stages in the order
+// they were added. Stages sharing nothing run concurrently on the job system.
+//
+// Every run records when each stage started and finished, and the critical path: the chain of
+// stages, each gated by the last of its predecessors to finish, that ends with the last stage done.
+class FrameGraph {
+public:
+    typedef std::function<void()> Stage;
+
+    // A stage's place in the last run, in milliseconds since the run began
+    struct Span {
+        const char* name;
+        double start;
+        double end;
+    };
+
+    // Stages must be added before the first run; returns the stage's index
+    size_t add(const char* name, const uint32_t reads, const uint32_t writes, Stage stage) {
+        const size_t index = nodes.size();
+        if (index == FRAME_GRAPH_MAX_STAGES) {
+            throw std::length_error("frame graph is full");
+        }
+        Node node;
+        node.name = name;
+        node.reads = reads;
+        node.writes = writes;
+        node.stage = std::move(stage);
+        for (size_t i = 0; i < index; ++i) {
+            Node& before = nodes[i];
+            if ((before.writes & (reads | writes)) != 0 || (before.reads & writes) != 0) {
+                before.successors.push_back(index);
+                node.predecessors.push_back(i);
+            }
+        }
+        nodes.push_back(std::move(node));
+        return index;
+    }
+
+    void run(JobSystem& jobs) {
+        if (pending.size() != nodes.size()) {
+            pending = std::vector<std::atomic<uint32_t>>(nodes.size());
+            spans.resize(nodes.size());
+        }
+
+        size_t ready[FRAME_GRAPH_MAX_STAGES];
+        size_t readyCount = 0;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            pending[i].store(static_cast<uint32_t>(nodes[i].predecessors.size()), std::memory_order_relaxed);
+            if (nodes[i].predecessors.empty()) {
+                ready[readyCount++] = i;
+            }
+        }
+
+        started = Clock::now();
+        runAll(jobs, ready, readyCount);
+        traceCriticalPath();
+    }
+
+    // Stages of the last run's critical path, first to last
+    const std::vector<size_t>& criticalPath() const {
+        return critical;
+    }
+
+    const Span& span(const size_t stage) const {
+        return spans[stage];
+    }
+
+    size_t size() const {
+        return nodes.size();
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Node {
+        const char* name;
+        uint32_t reads;
+        uint32_t writes;
+        Stage stage;
+        std::vector<size_t> predecessors;
+        std::vector<size_t> successors;
+    };
+
+    void runAll(JobSystem& jobs, const size_t* stages, const size_t count) {
+        jobs.parallel_for(0, count, 1, [this, &jobs, stages](const size_t first, const size_t last) {
+            for (size_t k = first; k < last; ++k) {
+                runStage(jobs, stages[k]);
+            }
+        });
+    }
+
+    // Run a stage, then whichever successors it was the last to wait for
+    void runStage(JobSystem& jobs, const size_t index) {
+        Node& node = nodes[index];
+        spans[index].name = node.name;
+        spans[index].start = elapsed();
+        node.stage();
+        spans[index].end = elapsed();
+
+        size_t ready[FRAME_GRAPH_MAX_STAGES];
+        size_t readyCount = 0;
+        for (const size_t next : node.successors) {
+            if (pending[next].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                ready[readyCount++] = next;
+            }
+        }
+        runAll(jobs, ready, readyCount);
+    }
+
+    void traceCriticalPath() {
+        critical.clear();
+        if (nodes.empty()) {
+            return;
+        }
+
+        size_t last = 0;
+        for (size_t i = 1; i < nodes.size(); ++i) {
+            if (spans[i].end > spans[last].end) {
+                last = i;
+            }
+        }
+        for (;;) {
+            critical.push_back(last);
+            const std::vector<size_t>& before = nodes[last].predecessors;
+            if (before.empty()) {
+                break;
+            }
+            size_t gate = before.front();
+            for (const size_t i : before) {
+                if (spans[i].end > spans[gate].end) {
+                    gate = i;
+                }
+            }
+            last = gate;
+        }
+        std::reverse(critical.begin(), critical.end());
+    }
+
+    double elapsed() const {
+        return std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+    }
+
+    std::vector<Node> nodes;
+    std::vector<std::atomic<uint32_t>> pending;
+    std::vector<Span> spans;
+    std::vector<size_t> critical;
+    Clock::time_point started;
+};
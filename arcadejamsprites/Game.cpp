@@ -6,6 +6,8 @@
 #include "Game.h"
 #include <iostream>
 #include <sstream>
+#include <random>
+#include <timeapi.h>
 
 extern void ExitGame() noexcept;
 
@@ -16,14 +18,18 @@ using Microsoft::WRL::ComPtr;
 
 namespace
 {
-    const XMVECTORF32 START_POSITION = { -200.f, 0.f, 0.f, 0.f };
     const XMVECTORF32 ROOM_BOUNDS = { 18.f, 16.f, 12.f, 0.f };
     constexpr float ROTATION_GAIN = 0.004f;
-    constexpr float MOVEMENT_GAIN = 4.f;
+
+    // simulation ticks per second, whatever the display refresh rate
+    constexpr double TICK_RATE = 60.0;
+
+    // the simulation thread sleeps until this long before its next tick, then one more sleep of
+    // this long; the timer period is 1 ms, so that is as fine as sleeps get
+    constexpr double SIM_SLEEP_MARGIN = 0.001;
 }
 
 /* TODO:
-Add more enemies (random spawn system)
 Bound player to single screen
 Add sound effects and music
 Fix hitbox on ball
@@ -46,6 +52,12 @@ Game::Game() noexcept(false)
 
 Game::~Game()
 {
+    if (m_simThread.joinable())
+    {
+        m_simRunning = false;
+        m_simThread.join();
+    }
+
     if (m_deviceResources)
     {
         m_deviceResources->WaitForGpu();
@@ -63,76 +75,82 @@ void Game::Initialize(HWND window, int width, int height)
     m_deviceResources->CreateWindowSizeDependentResources();
     CreateWindowSizeDependentResources();
 
-    // TODO: Change the timer settings if you want something other than the default variable timestep mode.
-    // e.g. for 60 FPS fixed timestep update logic, call:
-    /*
+    // Simulate on a fixed tick so game speed and update cost don't follow the frame rate.
+    // Render blends the last two ticks by how far the clock has run into the next one.
     m_timer.SetFixedTimeStep(true);
-    m_timer.SetTargetElapsedSeconds(1.0 / 60);
-    */
+    m_timer.SetTargetElapsedSeconds(1.0 / TICK_RATE);
 
     m_keyboard = std::make_unique<Keyboard>();
     m_mouse = std::make_unique<Mouse>();
     m_mouse->SetWindow(window);
     windowWidth = width;
     windowHeight = height;
-    BOUNDS = Vector2(width, -2 * height);
     m_cameraPos = START_POSITION;
+    m_prevCameraPos = m_cameraPos;
 
     // World creation
     World W();
     Dog D();
     NAME = GenerateName(1.f, 1.f);
+    UpdateScoreBoard();
+
+    addPlayStages(m_playGraph, m_play);
+
+    // the simulation has input to read before its first tick
+    m_inputs.back() = { m_keyboard->GetState(), m_mouse->GetState(), width, height };
+    m_inputs.publish();
+    m_simRunning = true;
+    m_simThread = std::thread([this] { Simulate(); });
 }
 
 #pragma region Frame Update
 // execute the basic game loop
+// the window thread only samples input and draws the latest frame, the simulation runs on its own thread
 void Game::Tick()
 {
-    m_timer.Tick([&]()
-    {
-        Update(m_timer);
-    });
+    auto kb = m_keyboard->GetState();
+    if (kb.Escape) {
+        ExitGame();
+    }
+
+    m_inputs.back() = { kb, m_mouse->GetState(), windowWidth, windowHeight };
+    m_inputs.publish();
 
     Render();
 }
 
-Vector3 Game::ProcessInput(const Keyboard::State& kb, const Mouse::State& mouse, Vector3& m_cameraPos, Dog& D) {
+// Simulation thread: tick on the fixed step and publish a frame after each run of ticks
+void Game::Simulate()
+{
+    // let the short sleeps below wake on time
+    timeBeginPeriod(1);
 
-    if (kb.Home)
+    while (m_simRunning)
     {
-        m_cameraPos = START_POSITION.v;
-    }
-
-    Vector3 move = Vector3::Zero;
-
-    if (kb.Up || kb.W) {
-        move.y += 1.f;
-        D.Up();
-    }
+        if (m_resetClock.exchange(false))
+        {
+            m_timer.ResetElapsedTime();
+        }
 
-    if (kb.Down || kb.S) {
-        move.y -= 1.f;
-        D.Down();
-    }
+        m_input = m_inputs.latest();
 
-    if (kb.Left || kb.A) {
-        move.x += 1.f;
-        D.Left();
-    }
+        const uint32_t before = m_timer.GetFrameCount();
+        m_timer.Tick([&]()
+        {
+            Update(m_timer);
+        });
+        if (m_timer.GetFrameCount() != before)
+        {
+            PublishFrame();
+        }
 
-    if (kb.Right || kb.D) {
-        move.x -= 1.f;
-        D.Right();
+        // sleeps can overshoot by a timer period, so the tick runs up to that late rather than
+        // the thread spinning for it; the fixed step keeps the simulation clock exact regardless
+        const double untilTick = (1.0 - m_timer.GetInterpolation()) / TICK_RATE;
+        std::this_thread::sleep_for(std::chrono::duration<double>(std::max(untilTick - SIM_SLEEP_MARGIN, SIM_SLEEP_MARGIN)));
     }
 
-    if (kb.PageUp || kb.Space)
-        // TODO: jump
-        // JUMPING = true;
-
-        if (kb.PageDown || kb.X)
-            move.z -= 1.f;
-
-    return move;
+    timeEndPeriod(1);
 }
 
 void Game::UpdatePlay(DX::StepTimer const& timer, const float &elapsedTime, const float &totalTime, const Keyboard::State& kb, const Mouse::State& mouse) {
@@ -141,77 +159,11 @@ void Game::UpdatePlay(DX::StepTimer const& timer, const float &elapsedTime, cons
         Mode = Score;
         all_scores.push_back({ SCORE, NAME });
         NAME = GenerateName(totalTime * 1.5f, totalTime);
+        UpdateScoreBoard();
     }
 
-    // prepare for player movement
-    Vector3 move = ProcessInput(kb, mouse, m_cameraPos, D);
-    Quaternion q = Quaternion::CreateFromYawPitchRoll(0.f, 0.f, 0.f);
-    move = Vector3::Transform(move, q);
-    move *= MOVEMENT_GAIN;
-    Vector3 newPos = m_cameraPos + move;
-
-    // check for terrain and crab collisions
-    if (!W.checkForCollisions(newPos)) {
-        // move player in sync with camera
-        m_cameraPos = newPos;
-        D.pos = Vector2(newPos.x, newPos.y);
-    }
-
-    // fire projectile
-    if (mouse.leftButton && W.projectiles.size() < 1) {
-        Vector2 to = m_cameraPos - Vector2(m_cameraPos.x + mouse.x - windowWidth / 2, m_cameraPos.y + mouse.y - windowHeight / 2);
-        W.createBall(m_cameraPos, to * 4.f);
-    }
-
-    // active projectile state
-    if (W.projectiles.size() > 0) {
-        Vector2 projPos = W.projectiles[0]->pos;
-        W.octo->update(totalTime, projPos);
-
-        for (auto& p : W.projectiles) {
-            // dead ball expire
-            if (p->velocity.Length() < 10.f) {
-                W.deleteBall();
-            }
-            else if (p->pos.x < -500.f) {
-                p->velocity.x = -1.5f * p->velocity.x;
-                p->pos.x = -499.f;
-            }
-            else {
-                p->update(elapsedTime);
-                // boolean hit = W.checkForCollisions(p->pos)
-            }
-        }
-    }
-
-    // process crab and player updates
-    for (Animal* entity : W.animals) {
-        if (entity->alive) {
-            entity->update();
-            // smush crabs
-            if (W.projectiles.size() > 0 && W.checkForCollision(W.projectiles[0]->pos, entity->pos)) {
-                entity->smush();
-                SCORE++;
-                //W.newCrabs(2);
-            }
-            // damage player
-            if (W.checkForCollision(D.pos, entity->pos)) {
-                D.dmg(totalTime);
-                D.velocity = entity->pos - D.pos;
-
-            }
-        }
-    }
-
-    // camera bump and player velocity wind down
-    m_cameraPos -= Vector3(D.velocity.x, D.velocity.y, 0.f);
-    D.pos = Vector2(m_cameraPos.x, m_cameraPos.y);
-    D.velocity *= 0.4;
-
-    if (m_cameraPos.y > BOUNDS.y - windowHeight) {
-        W.generateChunkAt(-windowWidth * 1.55f, BOUNDS.y);
-        BOUNDS.y += windowHeight;
-    }
+    m_play.tick = { elapsedTime, totalTime, kb, mouse, m_input.width, m_input.height };
+    m_playGraph.run(m_jobs);
 }
 
 // Update the world
@@ -224,12 +176,12 @@ void Game::Update(DX::StepTimer const& timer)
 
     elapsedTime;
 
-    auto kb = m_keyboard->GetState();
-    if (kb.Escape) {
-        ExitGame();
-    }
+    const Keyboard::State& kb = m_input.kb;
+    const Mouse::State& mouse = m_input.mouse;
 
-    auto mouse = m_mouse->GetState();
+    // what render blends from, held still outside play
+    m_prevCameraPos = m_cameraPos;
+    W.snapshot();
     
     // swap between game modes
     if (Mode == Play) {
@@ -253,6 +205,78 @@ void Game::Update(DX::StepTimer const& timer)
 
     PIXEndEvent();
 }
+
+// Snapshot the scoreboard for render frames to share, called whenever it changes
+void Game::UpdateScoreBoard()
+{
+    m_scoreBoard = std::make_shared<const ScoreBoard>(ScoreBoard{ NAME, all_scores });
+}
+
+// Copy what Render needs of the current tick into the back frame and hand it to the window thread
+void Game::PublishFrame()
+{
+    RenderFrame& frame = m_frames.back();
+    frame.tick = m_timer.GetFrameCount();
+    frame.published = std::chrono::steady_clock::now();
+    frame.lead = static_cast<float>(m_timer.GetInterpolation());
+    frame.prevCamera = m_prevCameraPos;
+    frame.camera = m_cameraPos;
+
+    // tiles inside the window around both cameras, so any blend between them is covered
+    const World::TileRange from = W.visibleTiles(m_prevCameraPos, m_input.width, m_input.height);
+    const World::TileRange to = W.visibleTiles(m_cameraPos, m_input.width, m_input.height);
+    const World::TileRange cells{
+        std::min(from.columnMin, to.columnMin), std::max(from.columnMax, to.columnMax),
+        std::min(from.rowMin, to.rowMin), std::max(from.rowMax, to.rowMax)
+    };
+    frame.tiles.clear();
+    W.forEachChunkInCells(cells,
+        [&](const World::Chunk& chunk, int c0, int c1, int r0, int r1) {
+            for (int i = r0; i <= r1; ++i) {
+                for (int j = c0; j <= c1; ++j) {
+                    frame.tiles.push_back(TileDraw{ World::tileAnchor(chunk.coord, j, i), &TILE_RECTS[chunk.type(World::Chunk::index(j, i))] });
+                }
+            }
+            return false;
+        });
+
+    frame.sprites.clear();
+    for (size_t i = 0; i < W.balls.size(); ++i) {
+        frame.sprites.push_back(SpriteDraw{ Ball, Vector2(W.balls.prevX[i], W.balls.prevY[i]), W.balls.pos(i), BALL_RECT, 1.f });
+    }
+    for (int type = 0; type < Descriptors::Count; ++type) {
+        const Herd& herd = W.herds[type];
+        for (size_t i = 0; i < herd.size(); ++i) {
+            frame.sprites.push_back(SpriteDraw{ static_cast<Descriptors>(type), Vector2(herd.prevX[i], herd.prevY[i]), herd.pos(i), herd.members[i]->rect, 4.f });
+        }
+    }
+
+    frame.dogRect = D.rect;
+    frame.dogHp = D.hp;
+    frame.mode = Mode;
+    frame.score = SCORE;
+    frame.board = m_scoreBoard;
+
+#ifdef _DEBUG
+    frame.tilesCulled = static_cast<int>(W.residentChunkCount()) * World::Chunk::Tiles - static_cast<int>(frame.tiles.size());
+    frame.liveCrabs = static_cast<uint32_t>(W.herds[Crab].size());
+    frame.liveAnimals = W.liveAnimals();
+    frame.animalCapacity = W.animalCapacity();
+    frame.spawned = W.crabsSpawned();
+    frame.despawned = W.crabsDespawned();
+
+    // stages that held up the last play tick, microseconds each
+    frame.criticalPath = L"critical path";
+    for (const size_t stage : m_playGraph.criticalPath()) {
+        const FrameGraph::Span& span = m_playGraph.span(stage);
+        std::wstring name_str;
+        StringToWString(name_str, span.name);
+        frame.criticalPath += L" > " + name_str + L" " + std::to_wstring(static_cast<int>((span.end - span.start) * 1000.0));
+    }
+#endif
+
+    m_frames.publish();
+}
 #pragma endregion
 
 void Game::RenderTitle() {
@@ -269,7 +293,7 @@ void Game::RenderTitle() {
         Vector2(windowWidth / 2, windowHeight / 2), Colors::White, 0.f, origin);
 }
 
-void Game::RenderScore() {
+void Game::RenderScore(const RenderFrame& frame) {
     const wchar_t* titletext = L"Leaderboard";
     Vector2 origin = { 0.f, 0.f };
 
@@ -282,7 +306,7 @@ void Game::RenderScore() {
 
     int row = 1;
 
-        for (auto& pair : all_scores) {
+        for (auto& pair : frame.board->scores) {
         ++row;
 
         const std::wstring score_str = std::to_wstring(pair.first);
@@ -300,28 +324,47 @@ void Game::RenderScore() {
     }
 }
 
-void Game::RenderUI() {
+void Game::RenderUI(const RenderFrame& frame) {
     // Name for scoreboard
     std::wstring wstmp;
-    StringToWString(wstmp, NAME);
+    StringToWString(wstmp, frame.board->name);
     Vector2 name_origin = m_font->MeasureString(wstmp.c_str()) / 2.f;
     m_font->DrawString(m_spriteBatch.get(), wstmp.c_str(),
         Vector2(windowWidth - 100.f, windowHeight - 125.f), Colors::White, 0.f, name_origin);
 
     // Score
     const wchar_t* output = L"Score:";
-    const std::wstring score_str = std::to_wstring(SCORE);
+    const std::wstring score_str = std::to_wstring(frame.score);
     Vector2 origin = m_font->MeasureString(output) / 2.f;
     m_font->DrawString(m_spriteBatch.get(), score_str.c_str(),
         Vector2(100.f, windowHeight - 100.f), Colors::White, 0.f, origin);
+
+#ifdef _DEBUG
+    // Tile draw volume for the last frame
+    const std::wstring tiles_str = L"tiles " + std::to_wstring(frame.tiles.size()) + L" / culled " + std::to_wstring(frame.tilesCulled);
+    m_font->DrawString(m_spriteBatch.get(), tiles_str.c_str(),
+        Vector2(20.f, 20.f), Colors::White, 0.f, Vector2(0.f, 0.f), 0.5f);
+
+    // Crabs against the spawn budget, animal pool occupancy (the octopus included) and spawner traffic
+    const std::wstring crabs_str = L"crabs " + std::to_wstring(frame.liveCrabs) + L" / " + std::to_wstring(CRAB_BUDGET)
+        + L" pool " + std::to_wstring(frame.liveAnimals) + L" / " + std::to_wstring(frame.animalCapacity)
+        + L" spawned " + std::to_wstring(frame.spawned) + L" despawned " + std::to_wstring(frame.despawned);
+    m_font->DrawString(m_spriteBatch.get(), crabs_str.c_str(),
+        Vector2(20.f, 50.f), Colors::White, 0.f, Vector2(0.f, 0.f), 0.5f);
+
+    // Stages that held up the last play tick
+    m_font->DrawString(m_spriteBatch.get(), frame.criticalPath.c_str(),
+        Vector2(20.f, 80.f), Colors::White, 0.f, Vector2(0.f, 0.f), 0.5f);
+#endif
 }
 
 #pragma region Frame Render
 // Draws the scene.
 void Game::Render()
 {
-    // Don't try to render anything before the first Update.
-    if (m_timer.GetFrameCount() == 0)
+    // Render only reads the newest frame the simulation has published, nothing before the first
+    const RenderFrame& frame = m_frames.latest();
+    if (frame.tick == 0)
     {
         return;
     }
@@ -335,55 +378,58 @@ void Game::Render()
 
     Vector3 offset = { static_cast<float>(windowWidth / 2), static_cast<float>(windowHeight / 2), 0.f };
 
+    // draw the world between the frame's last two ticks, by how far the simulation clock has run since
+    const float sincePublished = std::chrono::duration<float>(std::chrono::steady_clock::now() - frame.published).count();
+    const float alpha = std::min(frame.lead + sincePublished * static_cast<float>(TICK_RATE), 1.f);
+    const Vector3 camera = Vector3::Lerp(frame.prevCamera, frame.camera, alpha);
+
     ID3D12DescriptorHeap* heaps[] = { m_resourceDescriptors->Heap() };
     commandList->SetDescriptorHeaps(static_cast<UINT>(std::size(heaps)), heaps);
 
     // begin drawing sprite batch
     m_spriteBatch->Begin(commandList);
     
-    for (const auto &tile : W.tiles) {
-        m_spriteBatch->Draw(m_resourceDescriptors->GetGpuHandle(Descriptors::Sand),
-            GetTextureSize(m_texture_sand.Get()),
-           offset + m_cameraPos - tile->pos, &tile->rect, Colors::White, 0.f, Vector2(0, 0), 4.f);
-    }
-
-    for (const auto& proj : W.projectiles) {
-        m_spriteBatch->Draw(m_resourceDescriptors->GetGpuHandle(Descriptors::Ball),
-            GetTextureSize(m_texture_ball.Get()), 
-            offset + m_cameraPos - proj->pos, &proj->rect, Colors::White, 0.f, Vector2(0, 0), 1.f);
+    // the frame holds the tiles inside the window around either camera
+    const auto sandHandle = m_resourceDescriptors->GetGpuHandle(Descriptors::Sand);
+    const auto sandSize = GetTextureSize(m_texture_sand.Get());
+    for (const TileDraw& tile : frame.tiles) {
+        m_spriteBatch->Draw(sandHandle, sandSize,
+            offset + camera - tile.pos, tile.rect, Colors::White, 0.f, Vector2(0, 0), 4.f);
     }
 
-    for (const auto& animal : W.animals) {
-        if (animal->alive) {
-            m_spriteBatch->Draw(m_resourceDescriptors->GetGpuHandle(Descriptors::Crab),
-                GetTextureSize(m_texture_crab.Get()),
-                offset + m_cameraPos - animal->pos, &animal->rect, Colors::White, 0.f, Vector2(0, 0), 4.f);
+    // sprites come grouped by texture
+    Descriptors texture = Descriptors::Count;
+    D3D12_GPU_DESCRIPTOR_HANDLE handle = {};
+    XMUINT2 size = {};
+    for (const SpriteDraw& sprite : frame.sprites) {
+        if (sprite.texture != texture) {
+            texture = sprite.texture;
+            handle = m_resourceDescriptors->GetGpuHandle(texture);
+            size = GetTextureSize(SpriteTexture(texture));
         }
+        m_spriteBatch->Draw(handle, size,
+            offset + camera - Vector2::Lerp(sprite.from, sprite.to, alpha), &sprite.rect, Colors::White, 0.f, Vector2(0, 0), sprite.scale);
     }
 
-    m_spriteBatch->Draw(m_resourceDescriptors->GetGpuHandle(Descriptors::Octo),
-        GetTextureSize(m_texture_octo.Get()),
-        offset + m_cameraPos - W.octo->pos, &W.octo->rect, Colors::White, 0.f, Vector2(0, 0), 4.f);
-
     m_spriteBatch->Draw(m_resourceDescriptors->GetGpuHandle(Descriptors::Cat),
         GetTextureSize(m_texture_cat.Get()),
-        Vector2(windowWidth / 2.f, windowHeight / 2.f), &D.rect, Colors::White, 0.f, Vector2(0, 0), 4.f);
+        Vector2(windowWidth / 2.f, windowHeight / 2.f), &frame.dogRect, Colors::White, 0.f, Vector2(0, 0), 4.f);
 
     // draw HP
-    for (int i = 0; i < D.hp; ++i) {
+    for (int i = 0; i < frame.dogHp; ++i) {
         RECT hp_rect{ 0, 32, 32, 64 };
         m_spriteBatch->Draw(m_resourceDescriptors->GetGpuHandle(Descriptors::Cat),
             GetTextureSize(m_texture_cat.Get()),
             Vector2(windowWidth - 40.f * i - 100.f, windowHeight - 100.f), &hp_rect, Colors::White, 0.f, Vector2(0, 0), 1.5f);
     }
 
-    RenderUI();
+    RenderUI(frame);
 
-    if (Mode == Score) {
-        RenderScore();
+    if (frame.mode == Score) {
+        RenderScore(frame);
     }
 
-    if (Mode == Title) {
+    if (frame.mode == Title) {
         RenderTitle();
     }
 
@@ -424,6 +470,21 @@ void Game::Clear()
 
     PIXEndEvent(commandList);
 }
+
+// Texture a sprite is drawn from, its descriptor selects the heap slot
+ID3D12Resource* Game::SpriteTexture(Descriptors type) const
+{
+    switch (type)
+    {
+    case Ball:
+        return m_texture_ball.Get();
+    case Octo:
+        return m_texture_octo.Get();
+    case Crab:
+    default:
+        return m_texture_crab.Get();
+    }
+}
 #pragma endregion
 
 #pragma region Message Handlers
@@ -445,7 +506,8 @@ void Game::OnSuspending()
 
 void Game::OnResuming()
 {
-    m_timer.ResetElapsedTime();
+    // the simulation thread owns the timer
+    m_resetClock = true;
 
     // TODO: Game is being power-resumed (or returning from minimize).
 }
@@ -603,16 +665,14 @@ void Game::OnDeviceRestored()
 std::string Game::GenerateName(float input1, float input2) {
     std::string consonants = "bcdfghjklmnprstv";
     std::string vowels = "aeiouy";
-    Rand_int c(0, consonants.length());
-    Rand_int v(0, vowels.length());
-    c.seed(std::time(nullptr));
-    v.seed(std::time(nullptr));
-    int v1 = v();
-    int v2 = v();
-    int c1 = c();
-    int c2 = c();
-    int c3 = c();
-    int c4 = c();
+    std::default_random_engine re(static_cast<unsigned>(std::time(nullptr)));
+    std::uniform_int_distribution<int> c(0, static_cast<int>(consonants.length()) - 1);
+    std::uniform_int_distribution<int> v(0, static_cast<int>(vowels.length()) - 1);
+    int v1 = v(re);
+    int v2 = v(re);
+    int c1 = c(re);
+    int c3 = c(re);
+    int c4 = c(re);
     std::ostringstream mouth;
     mouth << static_cast<char>(std::toupper(consonants[c1])) << vowels[v1] << consonants[c3] << vowels[v2] << consonants[c4] << vowels[v2];
     return mouth.str();
@@ -9,6 +9,12 @@
 #include "World.h"
 #include "Animals.h"
 #include "Descriptors.h"
+#include "FrameGraph.h"
+#include "PlayTick.h"
+#include "TripleBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 
 // A basic game implementation that creates a D3D12 device and
@@ -55,13 +61,14 @@ public:
 
 private:
 
+    void Simulate();
     void Update(DX::StepTimer const& timer);
     void UpdatePlay(DX::StepTimer const& timer, const float& elapsedTime, const float& totalTime, const Keyboard::State& keyboard, const Mouse::State& mouse);
-    Vector3 ProcessInput(const Keyboard::State& kb, const Mouse::State& mouse, Vector3& m_cameraPos, Dog&);
     void Render();
     void RenderTitle();
-    void RenderScore();
-    void RenderUI();
+    void PublishFrame();
+    void UpdateScoreBoard();
+    ID3D12Resource* SpriteTexture(Descriptors type) const;
 
     void Clear();
 
@@ -89,12 +96,76 @@ private:
 
     ModeList Mode = Title;
 
+    // Input as the window thread last sampled it
+    struct InputFrame {
+        Keyboard::State kb;
+        Mouse::State mouse;
+        int width;
+        int height;
+    };
+
+    // A sprite drawn between where it was before its last tick and where it is now
+    struct SpriteDraw {
+        Descriptors texture;
+        DirectX::SimpleMath::Vector2 from;
+        DirectX::SimpleMath::Vector2 to;
+        RECT rect;
+        float scale;
+    };
+
+    struct TileDraw {
+        DirectX::SimpleMath::Vector2 pos;
+        const RECT* rect;
+    };
+
+    // Past scores and the name the next one goes under
+    struct ScoreBoard {
+        std::string name;
+        std::vector<std::pair<int, std::string>> scores;
+    };
+
+    // Everything Render reads of one simulation tick, never changed once published
+    struct RenderFrame {
+        uint32_t tick = 0;
+        std::chrono::steady_clock::time_point published;
+        // how far the simulation clock had run into the next tick when this was published
+        float lead = 0.f;
+        DirectX::SimpleMath::Vector3 prevCamera;
+        DirectX::SimpleMath::Vector3 camera;
+        std::vector<TileDraw> tiles;
+        std::vector<SpriteDraw> sprites;
+        RECT dogRect = {};
+        int dogHp = 0;
+        ModeList mode = Title;
+        int score = 0;
+        // shared by every frame until the scoreboard next changes
+        std::shared_ptr<const ScoreBoard> board;
+#ifdef _DEBUG
+        int tilesCulled = 0;
+        uint32_t liveCrabs = 0;
+        uint32_t liveAnimals = 0;
+        uint32_t animalCapacity = 0;
+        uint64_t spawned = 0;
+        uint64_t despawned = 0;
+        std::wstring criticalPath;
+#endif
+    };
+
+    void RenderScore(const RenderFrame& frame);
+    void RenderUI(const RenderFrame& frame);
+
     // Device resources.
     std::unique_ptr<DX::DeviceResources>        m_deviceResources;
 
-    // Rendering loop timer.
+    // Simulation timer, owned by the simulation thread.
     DX::StepTimer                               m_timer;
 
+    // Worker threads the simulation fans entity loops out to.
+    JobSystem                                   m_jobs;
+
+    // Play tick stages.
+    FrameGraph                                  m_playGraph;
+
     // If using the DirectX Tool Kit for DX12, uncomment this line:
     std::unique_ptr<DirectX::GraphicsMemory> m_graphicsMemory;
     std::unique_ptr<DirectX::DescriptorHeap> m_resourceDescriptors;
@@ -113,6 +184,9 @@ private:
     std::unique_ptr<DirectX::Mouse> m_mouse;
     DirectX::SimpleMath::Vector3 m_cameraPos;
 
+    // camera at the start of the last tick, render interpolates from it
+    DirectX::SimpleMath::Vector3 m_prevCameraPos;
+
     std::unique_ptr<DirectX::SpriteFont> m_font;
     DirectX::SimpleMath::Vector2 m_fontPos;
 
@@ -121,10 +195,26 @@ private:
 
     int windowWidth = 0;
     int windowHeight = 0;
-    Vector2 BOUNDS;
+
+    // The simulation runs on its own thread: the window thread hands it input and it hands back
+    // render frames, each through a triple buffer, so neither ever waits on the other
+    std::thread m_simThread;
+    std::atomic<bool> m_simRunning{ false };
+    std::atomic<bool> m_resetClock{ false };
+    TripleBuffer<InputFrame> m_inputs;
+    TripleBuffer<RenderFrame> m_frames;
+
+    // simulation thread's copy of the input for the current tick
+    InputFrame m_input = {};
+
+    // the scoreboard as of the last game over, handed to every frame published since
+    std::shared_ptr<const ScoreBoard> m_scoreBoard;
 
     int SCORE = 0;
     boolean INPUT = false;
 
     std::string NAME;
+
+    // what the play stages work on and see of the current tick
+    PlaySession m_play{ W, D, m_cameraPos, SCORE, m_jobs, {}, 0.f };
 };
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "pch.h"
+#include <cstdint>
+
+// Integer division rounding towards negative infinity, so cell -1 covers -size .. -1
+inline int floorDiv(const int a, const int b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// Spatial hash of a grid cell (Teschner et al.), spelled out rather than std::hash so the
+// value is the same from any build; chunk seeds and the chunk cache file depend on that
+inline uint32_t hashCell(const int x, const int y) {
+    return static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(y) * 19349663u;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "pch.h"
+#include "Descriptors.h"
+#include "Animals.h"
+#include "Motion.h"
+#include "Jobs.h"
+#include <vector>
+
+using namespace DirectX::SimpleMath;
+
+// how far out in the water from the foot of the cliff the octopus waits
+constexpr float OCTO_SHORE_OFFSET = 83.f;
+
+// crabs moved per job, a multiple of the widest CrabMotion kernel
+constexpr size_t CRAB_MOTION_GRAIN = 512;
+
+// All live animals of one Descriptors type. Positions are packed by axis and
+// members[i] sits at (x[i], y[i]), so a behavior walks plain float arrays.
+// (prevX[i], prevY[i]) is where it was before the current tick, for render interpolation.
+struct Herd {
+    std::vector<Animal*> members;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> prevX;
+    std::vector<float> prevY;
+
+    void reserve(const size_t count) {
+        members.reserve(count);
+        x.reserve(count);
+        y.reserve(count);
+        prevX.reserve(count);
+        prevY.reserve(count);
+    }
+
+    void push(Animal* an, const Vector2 pos) {
+        members.push_back(an);
+        x.push_back(pos.x);
+        y.push_back(pos.y);
+        prevX.push_back(pos.x);
+        prevY.push_back(pos.y);
+    }
+
+    // Drop member i by moving the last member into its place
+    void swapRemove(const size_t i) {
+        members[i] = members.back();
+        x[i] = x.back();
+        y[i] = y.back();
+        prevX[i] = prevX.back();
+        prevY[i] = prevY.back();
+        members.pop_back();
+        x.pop_back();
+        y.pop_back();
+        prevX.pop_back();
+        prevY.pop_back();
+    }
+
+    // Remember every position before a tick moves them
+    void snapshot() {
+        prevX.assign(x.begin(), x.end());
+        prevY.assign(y.begin(), y.end());
+    }
+
+    Vector2 pos(const size_t i) const {
+        return Vector2(x[i], y[i]);
+    }
+
+    size_t size() const {
+        return members.size();
+    }
+
+    bool empty() const {
+        return members.empty();
+    }
+};
+
+// What a behavior can see of the current tick
+struct TickContext {
+    float elapsed;
+    float total;
+    bool ballActive;
+    Vector2 ballPos;
+    float coastX; // where the water meets the cliff on ballPos' row
+    JobSystem* jobs;
+};
+
+// Advances every member of a herd in one loop
+typedef void (*HerdBehavior)(Herd& herd, const TickContext& tick);
+
+// crabs wobble along y, each crab on its own so ranges can move in parallel
+inline void crabBehavior(Herd& herd, const TickContext& tick) {
+    float* x = herd.x.data();
+    float* y = herd.y.data();
+    tick.jobs->parallel_for(0, herd.size(), CRAB_MOTION_GRAIN, [x, y](const size_t first, const size_t last) {
+        CrabMotion::advance(x + first, y + first, last - first);
+    });
+}
+
+// octopuses track the ball's row while it is in play, keeping just off that row's coast
+inline void octoBehavior(Herd& herd, const TickContext& tick) {
+    if (!tick.ballActive) {
+        return;
+    }
+    std::fill(herd.x.begin(), herd.x.end(), tick.coastX - OCTO_SHORE_OFFSET);
+    std::fill(herd.y.begin(), herd.y.end(), tick.ballPos.y);
+}
+
+// Behavior of each herd, indexed by Descriptors; nullptr for descriptors that aren't creatures.
+// A new creature type is a descriptor, a behavior here and a texture in Game::SpriteTexture.
+const HerdBehavior HERD_BEHAVIORS[Descriptors::Count] = {
+    nullptr,        // Cat, the player's dog moves with the camera
+    nullptr,        // Ball
+    nullptr,        // Sand
+    nullptr,        // Cliff
+    &crabBehavior,  // Crab
+    &octoBehavior,  // Octo
+    nullptr,        // Water
+    nullptr,        // MyFont
+};
+static_assert(Descriptors::Count == 8, "add the new descriptor to HERD_BEHAVIORS");
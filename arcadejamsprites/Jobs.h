@@ -0,0 +1,203 @@
+#pragma once
+
+#include "pch.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool for data parallel loops over entity ranges.
+//
+// Every worker owns a deque of range tasks, and so does the thread calling parallel_for.
+// A thread splits the task it holds in half until it is no larger than the grain, pushing
+// the upper halves to the back of its own deque and running the lower half itself. It pops
+// from the back, so it keeps working on the most recently split, cache warm ranges. Idle
+// threads steal from the front of other deques, where the largest ranges sit.
+//
+// The caller runs tasks too until its whole range is done, so a system with no workers
+// runs parallel_for serially in order. Bodies write only to their own range; anything they
+// produce is reduced by the caller in index order afterwards, so results never depend on
+// which thread ran which range.
+class JobSystem {
+public:
+    // One worker per hardware thread besides the caller
+    JobSystem() : JobSystem(defaultWorkers()) {}
+
+    explicit JobSystem(const unsigned workerCount) {
+        // queue 0 belongs to threads outside the pool
+        for (unsigned i = 0; i <= workerCount; ++i) {
+            queues.emplace_back(new WorkQueue());
+        }
+        for (unsigned i = 1; i <= workerCount; ++i) {
+            workers.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // body(first, last) over [begin, end) in ranges of at most grain, returning once all have run.
+    // Ranges may run on any thread in any order.
+    template <typename TBody>
+    void parallel_for(const size_t begin, const size_t end, const size_t grain, const TBody& body) {
+        if (begin >= end) {
+            return;
+        }
+        if (workers.empty() || end - begin <= grain) {
+            body(begin, end);
+            return;
+        }
+
+        Batch batch;
+        batch.body = &body;
+        batch.invoke = [](const void* fn, const size_t first, const size_t last) {
+            (*static_cast<const TBody*>(fn))(first, last);
+        };
+        batch.grain = std::max<size_t>(grain, 1);
+        batch.remaining = end - begin;
+
+        const unsigned self = currentQueue();
+        run(self, Task{ &batch, begin, end });
+        while (batch.remaining.load(std::memory_order_acquire) != 0) {
+            Task task;
+            if (take(self, task)) {
+                run(self, task);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    unsigned workerCount() const {
+        return static_cast<unsigned>(workers.size());
+    }
+
+    static unsigned defaultWorkers() {
+        const unsigned hardware = std::thread::hardware_concurrency();
+        return hardware > 1 ? hardware - 1 : 0;
+    }
+
+private:
+    // One parallel_for call, on its caller's stack until every element has run
+    struct Batch {
+        const void* body;
+        void (*invoke)(const void* body, size_t first, size_t last);
+        size_t grain;
+        std::atomic<size_t> remaining;
+    };
+
+    struct Task {
+        Batch* batch;
+        size_t begin;
+        size_t end;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void work(const unsigned self) {
+        workerIndex() = WorkerIndex{ this, self };
+        for (;;) {
+            Task task;
+            if (take(self, task)) {
+                run(self, task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait(lock, [this] { return stopping || queued.load() != 0; });
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+    // Split down to the grain, then run what is left
+    void run(const unsigned self, Task task) {
+        Batch& batch = *task.batch;
+        while (task.end - task.begin > batch.grain) {
+            const size_t mid = task.begin + (task.end - task.begin) / 2;
+            push(self, Task{ task.batch, mid, task.end });
+            task.end = mid;
+        }
+        batch.invoke(batch.body, task.begin, task.end);
+        // last touch of the batch, its owner may return as soon as this reaches zero
+        batch.remaining.fetch_sub(task.end - task.begin, std::memory_order_release);
+    }
+
+    void push(const unsigned self, const Task task) {
+        {
+            std::lock_guard<std::mutex> lock(queues[self]->mutex);
+            queues[self]->tasks.push_back(task);
+        }
+        queued.fetch_add(1);
+        {
+            // a worker between its last take and its wait still sees the new task
+            std::lock_guard<std::mutex> lock(wakeMutex);
+        }
+        wake.notify_one();
+    }
+
+    // Newest task of our own queue, else the oldest of the first other queue that has one
+    bool take(const unsigned self, Task& task) {
+        const unsigned count = static_cast<unsigned>(queues.size());
+        for (unsigned k = 0; k < count; ++k) {
+            const unsigned victim = (self + k) % count;
+            WorkQueue& queue = *queues[victim];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (victim == self) {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+            }
+            else {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+            queued.fetch_sub(1);
+            return true;
+        }
+        return false;
+    }
+
+    // Which queue this thread owns in which pool, so nested loops stay on their worker's queue
+    struct WorkerIndex {
+        const JobSystem* system;
+        unsigned queue;
+    };
+
+    static WorkerIndex& workerIndex() {
+        static thread_local WorkerIndex index = { nullptr, 0 };
+        return index;
+    }
+
+    unsigned currentQueue() const {
+        const WorkerIndex& index = workerIndex();
+        return index.system == this ? index.queue : 0;
+    }
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued{ 0 };
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
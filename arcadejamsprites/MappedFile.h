@@ -0,0 +1,74 @@
+#pragma once
+
+#include "pch.h"
+
+// A file mapped read/write in full for as long as it is open.
+// open creates the file if needed and sets its size to exactly the bytes asked for,
+// so the mapping never has to grow; existing contents up to that size are kept.
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Start of the mapped bytes, nullptr if the file can't be opened, sized or mapped
+    uint8_t* open(const wchar_t* path, const size_t bytes) {
+        close();
+
+        file = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            file = nullptr;
+            return nullptr;
+        }
+
+        LARGE_INTEGER size = {};
+        if (!GetFileSizeEx(file, &size) || size.QuadPart != static_cast<long long>(bytes)) {
+            LARGE_INTEGER end = {};
+            end.QuadPart = static_cast<long long>(bytes);
+            if (!SetFilePointerEx(file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+                close();
+                return nullptr;
+            }
+        }
+
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+        if (!mapping) {
+            close();
+            return nullptr;
+        }
+
+        view = static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+        if (!view) {
+            close();
+            return nullptr;
+        }
+        return view;
+    }
+
+    void close() {
+        if (view) {
+            FlushViewOfFile(view, 0);
+            UnmapViewOfFile(view);
+        }
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        if (file) {
+            CloseHandle(file);
+        }
+        view = nullptr;
+        mapping = nullptr;
+        file = nullptr;
+    }
+
+private:
+    HANDLE file = nullptr;
+    HANDLE mapping = nullptr;
+    uint8_t* view = nullptr;
+};
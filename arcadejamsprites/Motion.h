@@ -0,0 +1,138 @@
+#pragma once
+
+#include "pch.h"
+#include <intrin.h>
+#include <immintrin.h>
+
+// crab vertical wobble, world units per tick at the top of the cosine
+constexpr float CRAB_WOBBLE = 2.f;
+
+// Polynomial cosine, shared by every lane width so all paths agree bit for bit.
+//
+// x is reduced by the nearest multiple of pi (Cody-Waite, pi split into an exact head and
+// a tail) to r in [-pi/2, pi/2], so cos(x) = (-1)^q cos(r). cos(r) is its Taylor series to
+// r^12, whose truncation error is under 7e-9 on that range. With float rounding the result
+// is within 2.5e-7 of libm for |x| up to 1e4 and 1.5e-6 up to 1e5.
+namespace FastCos {
+    constexpr float InvPi = 0.318309886f;
+    constexpr float PiHi = 3.140625f;            // 8 significant bits, so q * PiHi is exact
+    constexpr float PiLo = 9.67653589793e-4f;    // pi - PiHi
+    constexpr float C2 = -1.f / 2.f;
+    constexpr float C4 = 1.f / 24.f;
+    constexpr float C6 = -1.f / 720.f;
+    constexpr float C8 = 1.f / 40320.f;
+    constexpr float C10 = -1.f / 3628800.f;
+    constexpr float C12 = 1.f / 479001600.f;
+
+    inline float scalar(const float x) {
+        const float q = std::nearbyint(x * InvPi);
+        const float r = (x - q * PiHi) - q * PiLo;
+        const float r2 = r * r;
+        const float c = 1.f + r2 * (C2 + r2 * (C4 + r2 * (C6 + r2 * (C8 + r2 * (C10 + r2 * C12)))));
+        return (static_cast<int>(q) & 1) ? -c : c;
+    }
+
+    inline __m128 sse2(const __m128 x) {
+        const __m128i qi = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(InvPi)));
+        const __m128 q = _mm_cvtepi32_ps(qi);
+        __m128 r = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(PiHi)));
+        r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(PiLo)));
+        const __m128 r2 = _mm_mul_ps(r, r);
+        __m128 c = _mm_set1_ps(C12);
+        c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(C10));
+        c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(C8));
+        c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(C6));
+        c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(C4));
+        c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(C2));
+        c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(1.f));
+        // odd q flips the sign bit
+        const __m128 sign = _mm_castsi128_ps(_mm_slli_epi32(qi, 31));
+        return _mm_xor_ps(c, sign);
+    }
+
+    // No FMA, so rounding matches the SSE2 and scalar paths
+    inline __m256 avx2(const __m256 x) {
+        const __m256i qi = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(InvPi)));
+        const __m256 q = _mm256_cvtepi32_ps(qi);
+        __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(q, _mm256_set1_ps(PiHi)));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(q, _mm256_set1_ps(PiLo)));
+        const __m256 r2 = _mm256_mul_ps(r, r);
+        __m256 c = _mm256_set1_ps(C12);
+        c = _mm256_add_ps(_mm256_mul_ps(c, r2), _mm256_set1_ps(C10));
+        c = _mm256_add_ps(_mm256_mul_ps(c, r2), _mm256_set1_ps(C8));
+        c = _mm256_add_ps(_mm256_mul_ps(c, r2), _mm256_set1_ps(C6));
+        c = _mm256_add_ps(_mm256_mul_ps(c, r2), _mm256_set1_ps(C4));
+        c = _mm256_add_ps(_mm256_mul_ps(c, r2), _mm256_set1_ps(C2));
+        c = _mm256_add_ps(_mm256_mul_ps(c, r2), _mm256_set1_ps(1.f));
+        const __m256 sign = _mm256_castsi256_ps(_mm256_slli_epi32(qi, 31));
+        return _mm256_xor_ps(c, sign);
+    }
+}
+
+// Crab motion over contiguous position arrays: y[i] += cos(x[i]) * CRAB_WOBBLE.
+// The widest kernel the CPU and OS support is picked once, on first use.
+class CrabMotion {
+public:
+    typedef void (*Kernel)(const float* x, float* y, size_t count);
+
+    static void advance(const float* x, float* y, const size_t count) {
+        static const Kernel kernel = select();
+        kernel(x, y, count);
+    }
+
+    static void scalar(const float* x, float* y, const size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            y[i] += FastCos::scalar(x[i]) * CRAB_WOBBLE;
+        }
+    }
+
+    static void sse2(const float* x, float* y, const size_t count) {
+        const __m128 wobble = _mm_set1_ps(CRAB_WOBBLE);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128 c = FastCos::sse2(_mm_loadu_ps(x + i));
+            _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(c, wobble)));
+        }
+        scalar(x + i, y + i, count - i);
+    }
+
+    static void avx2(const float* x, float* y, const size_t count) {
+        const __m256 wobble = _mm256_set1_ps(CRAB_WOBBLE);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256 c = FastCos::avx2(_mm256_loadu_ps(x + i));
+            _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(c, wobble)));
+        }
+        // keep the upper halves of the YMM registers from stalling the SSE code that follows
+        _mm256_zeroupper();
+        scalar(x + i, y + i, count - i);
+    }
+
+    static Kernel select() {
+        int info[4] = {};
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        const bool sse2Bit = (info[3] & (1 << 26)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avxBit = (info[2] & (1 << 28)) != 0;
+
+        // AVX needs the OS to save YMM state, XCR0 bits 1 and 2
+        const bool ymmSaved = osxsave && avxBit && (_xgetbv(0) & 0x6) == 0x6;
+
+        bool avx2Bit = false;
+        if (maxLeaf >= 7) {
+            __cpuidex(info, 7, 0);
+            avx2Bit = (info[1] & (1 << 5)) != 0;
+        }
+
+        if (ymmSaved && avx2Bit) {
+            return &avx2;
+        }
+        if (sse2Bit) {
+            return &sse2;
+        }
+        return &scalar;
+    }
+};
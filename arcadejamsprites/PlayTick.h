@@ -0,0 +1,226 @@
+#pragma once
+
+#include "pch.h"
+#include "World.h"
+#include "Animals.h"
+#include "FrameGraph.h"
+#include "Jobs.h"
+
+// where the camera starts, and where Home takes it back to
+const DirectX::XMVECTORF32 START_POSITION = { -200.f, 0.f, 0.f, 0.f };
+
+// camera travel per tick for each held direction
+constexpr float MOVEMENT_GAIN = 4.f;
+
+// seconds between throws while the button is held
+constexpr float BALL_COOLDOWN = 0.3f;
+
+// State the play stages read and write, the frame graph orders any two stages sharing a bit
+enum PlayState : uint32_t {
+    PlayInput = 1u << 0,        // this tick's keyboard and mouse
+    PlayCamera = 1u << 1,
+    PlayDog = 1u << 2,
+    PlayBalls = 1u << 3,        // balls and the throw cooldown
+    PlayCrabs = 1u << 4,        // the crab herd, positions and alive flags
+    PlayOcto = 1u << 5,
+    PlayCrabGrid = 1u << 6,     // broadphase and its candidate pairs
+    PlayChunks = 1u << 7,       // resident terrain and where it was streamed around
+    PlayChunkEvents = 1u << 8,  // chunks streamed in and out, still to be settled
+    PlayAnimals = 1u << 9,      // animal pool, handles and spawner books
+    PlayScore = 1u << 10,
+    PlayHerds = 1u << 11,       // herds without a stage of their own
+};
+
+// What the play stages see of the current tick
+struct PlayTick {
+    float elapsed;
+    float total;
+    DirectX::Keyboard::State kb;
+    DirectX::Mouse::State mouse;
+    // window size, throws aim from its center towards the mouse
+    int width;
+    int height;
+};
+
+// Everything the play stages work on. Game binds it to its own world and player, a headless
+// run to a world and player of its own, and both tick through the same stages.
+struct PlaySession {
+    World& world;
+    Dog& dog;
+    DirectX::SimpleMath::Vector3& camera;
+    int& score;
+    JobSystem& jobs;
+    PlayTick tick;
+    // tick.total of the last ball thrown
+    float lastThrow;
+};
+
+// Camera move for the keys held, turning the dog to face it
+inline Vector3 processInput(const DirectX::Keyboard::State& kb, const DirectX::Mouse::State& mouse, Vector3& cameraPos, Dog& D) {
+
+    if (kb.Home)
+    {
+        cameraPos = START_POSITION.v;
+    }
+
+    Vector3 move = Vector3::Zero;
+
+    if (kb.Up || kb.W) {
+        move.y += 1.f;
+        D.Up();
+    }
+
+    if (kb.Down || kb.S) {
+        move.y -= 1.f;
+        D.Down();
+    }
+
+    if (kb.Left || kb.A) {
+        move.x += 1.f;
+        D.Left();
+    }
+
+    if (kb.Right || kb.D) {
+        move.x -= 1.f;
+        D.Right();
+    }
+
+    if (kb.PageUp || kb.Space)
+        // TODO: jump
+        // JUMPING = true;
+
+        if (kb.PageDown || kb.X)
+            move.z -= 1.f;
+
+    return move;
+}
+
+// The play tick, stage by stage in the order they used to run in.
+// Each stage declares the state it reads and writes, and the graph runs stages that share
+// nothing side by side: crab movement runs alongside chunk streaming, the player and the balls.
+// The stages hold on to play, which must outlive graph.
+inline void addPlayStages(FrameGraph& graph, PlaySession& play) {
+
+    // stream terrain chunks around where the camera ended last tick
+    // arrivals and departures are queued, the herds only change when they are settled
+    graph.add("stream", PlayCamera, PlayChunks | PlayChunkEvents, [&play] {
+        play.world.streamChunks(play.camera);
+    });
+
+    // crabs only need the clock
+    graph.add("crabs", 0, PlayCrabs, [&play] {
+        const TickContext tick = { play.tick.elapsed, play.tick.total, false, Vector2(), 0.f, &play.jobs };
+        play.world.updateHerd(Crab, tick);
+    });
+
+    graph.add("move", PlayInput | PlayChunks, PlayCamera | PlayDog, [&play] {
+        // prepare for player movement
+        Vector3 move = processInput(play.tick.kb, play.tick.mouse, play.camera, play.dog);
+        Quaternion q = Quaternion::CreateFromYawPitchRoll(0.f, 0.f, 0.f);
+        move = Vector3::Transform(move, q);
+        move *= MOVEMENT_GAIN;
+        Vector3 newPos = play.camera + move;
+
+        // check for terrain collisions
+        if (!play.world.checkForCollisions(newPos)) {
+            // move player in sync with camera
+            play.camera = newPos;
+            play.dog.pos = Vector2(newPos.x, newPos.y);
+        }
+    });
+
+    // fire projectile, one per BALL_COOLDOWN while the button is held
+    graph.add("fire", PlayInput | PlayCamera, PlayBalls, [&play] {
+        const DirectX::Mouse::State& mouse = play.tick.mouse;
+        if (mouse.leftButton && play.tick.total - play.lastThrow >= BALL_COOLDOWN) {
+            Vector2 to = play.camera - Vector2(play.camera.x + mouse.x - play.tick.width / 2, play.camera.y + mouse.y - play.tick.height / 2);
+            if (play.world.balls.launch(Vector2(play.camera.x, play.camera.y), to * 4.f)) {
+                play.lastThrow = play.tick.total;
+            }
+        }
+    });
+
+    // the octopus sees the oldest ball where it was at the start of the tick
+    const auto ballTick = [&play] {
+        TickContext tick = { play.tick.elapsed, play.tick.total, false, Vector2(), 0.f, &play.jobs };
+        if (!play.world.balls.empty()) {
+            tick.ballActive = true;
+            tick.ballPos = play.world.balls.pos(0);
+            tick.coastX = play.world.coastX(tick.ballPos.y);
+        }
+        return tick;
+    };
+    graph.add("octopus", PlayBalls, PlayOcto, [&play, ballTick] {
+        play.world.updateHerd(Octo, ballTick());
+    });
+
+    // every other creature in HERD_BEHAVIORS, with the octopus' view of the ball
+    graph.add("herds", PlayBalls, PlayHerds, [&play, ballTick] {
+        const TickContext tick = ballTick();
+        for (int type = 0; type < Descriptors::Count; ++type) {
+            if (type != Crab && type != Octo && HERD_BEHAVIORS[type]) {
+                play.world.updateHerd(static_cast<Descriptors>(type), tick);
+            }
+        }
+    });
+
+    // expire resting balls, bounce and integrate the rest, then send any that ran into a cliff back off it
+    graph.add("balls", PlayChunks, PlayBalls, [&play] {
+        play.world.balls.step(play.tick.elapsed);
+        play.world.bounceBallsOffCliffs();
+    });
+
+    // the broadphase pairs the dog and each ball's path with the crabs near it, the exact test only runs on those
+    graph.add("bites", PlayCrabs, PlayDog | PlayCrabGrid, [&play] {
+        play.world.indexCrabs();
+        const Herd& crabs = play.world.herds[Crab];
+        for (const CandidatePair& pair : play.world.crabCandidates(&play.dog.pos, 1)) {
+            const Vector2 pos = crabs.pos(pair.entity);
+            if (play.world.checkForCollision(play.dog.pos, pos)) {
+                // damage player
+                play.dog.dmg(play.tick.total);
+                play.dog.velocity = pos - play.dog.pos;
+            }
+        }
+    });
+
+    // balls are swept from where they started the tick, so none tunnel through a crab however far they moved
+    // the sweeps run across the job system, the hits are applied here in pair order so the score matches a serial run
+    // herds only hold the living, the dead are compacted out at the end of the tick
+    graph.add("smush", PlayBalls, PlayCrabs | PlayCrabGrid | PlayScore, [&play] {
+        const Herd& crabs = play.world.herds[Crab];
+        const std::vector<CandidatePair>& ballPairs = play.world.ballCandidates();
+        const std::vector<uint8_t>& ballHits = play.world.testBallCandidates(play.jobs);
+        for (size_t k = 0; k < ballPairs.size(); ++k) {
+            Animal* crab = crabs.members[ballPairs[k].entity];
+            // smush crabs, once even if two balls land on the same one
+            if (ballHits[k] && crab->alive) {
+                crab->smush();
+                play.score++;
+            }
+        }
+    });
+
+    // camera bump and player velocity wind down
+    graph.add("bump", PlayDog, PlayCamera | PlayDog, [&play] {
+        play.camera -= Vector3(play.dog.velocity.x, play.dog.velocity.y, 0.f);
+        play.dog.pos = Vector2(play.camera.x, play.camera.y);
+        play.dog.velocity *= 0.4;
+    });
+
+    // return smushed crabs, move the rest's counts to the chunks they walked into,
+    // then despawn and populate the chunks streamed this tick, then top up the rest
+    const uint32_t herds = PlayCrabs | PlayOcto | PlayHerds | PlayAnimals;
+    graph.add("compact", 0, herds, [&play] {
+        play.world.compactAnimals();
+    });
+    graph.add("rehome", PlayChunks, herds, [&play] {
+        play.world.rehomeCrabs();
+    });
+    graph.add("settle", PlayChunks, herds | PlayChunkEvents, [&play] {
+        play.world.settleChunks();
+    });
+    graph.add("refill", PlayChunks, herds, [&play] {
+        play.world.refillCrabs();
+    });
+}
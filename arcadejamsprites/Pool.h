@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Fixed capacity slab of T with an intrusive free list.
+// All slots are allocated up front; create and destroy only construct and destruct in place,
+// so a steady stream of spawns and despawns never touches the heap.
+template <typename T>
+class Pool {
+public:
+    explicit Pool(uint32_t capacity) :
+        slotCount(capacity),
+        slots(new Slot[capacity])
+    {
+        for (uint32_t i = 0; i < capacity; ++i) {
+            slots[i].next = i + 1;
+            slots[i].live = false;
+        }
+    }
+
+    ~Pool() {
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            if (slots[i].live) {
+                slots[i].get()->~T();
+            }
+        }
+    }
+
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    // Construct a T in a free slot, nullptr when the pool is exhausted
+    template <typename... Args>
+    T* create(Args&&... args) {
+        if (freeHead == slotCount) {
+            return nullptr;
+        }
+        Slot& slot = slots[freeHead];
+        freeHead = slot.next;
+        slot.live = true;
+        ++liveCount;
+        return new (&slot.storage) T(std::forward<Args>(args)...);
+    }
+
+    // Destruct and return the slot to the free list
+    void destroy(T* object) {
+        Slot* slot = reinterpret_cast<Slot*>(object);
+        object->~T();
+        slot->live = false;
+        slot->next = freeHead;
+        freeHead = static_cast<uint32_t>(slot - slots.get());
+        --liveCount;
+    }
+
+    uint32_t live() const {
+        return liveCount;
+    }
+
+    uint32_t capacity() const {
+        return slotCount;
+    }
+
+private:
+    // storage comes first so a T* is also its Slot*
+    struct Slot {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        uint32_t next;
+        bool live;
+
+        T* get() {
+            return reinterpret_cast<T*>(&storage);
+        }
+    };
+
+    uint32_t slotCount;
+    std::unique_ptr<Slot[]> slots;
+    uint32_t freeHead = 0;
+    uint32_t liveCount = 0;
+};
@@ -0,0 +1,235 @@
+#pragma once
+
+#include "pch.h"
+#include <emmintrin.h>
+#include <vector>
+
+using namespace DirectX::SimpleMath;
+
+constexpr int SPEED = 2;
+
+constexpr float RESISTANCE_C = 0.9f;
+
+// balls in flight at once
+constexpr uint32_t PROJECTILE_CAPACITY = 4096;
+
+// launch speed, world units per second
+constexpr float BALL_SPEED = SPEED * 100.f * 10.f;
+
+// per tick pull towards the baseline
+constexpr float BALL_GRAVITY = -9.8f * SPEED * RESISTANCE_C;
+
+// a floor bounce keeps this much of each velocity component, and stops a ball slower than BALL_STOP_SPEED
+constexpr float BALL_BOUNCE_X = 0.5f;
+constexpr float BALL_BOUNCE_Y = -0.4f;
+constexpr float BALL_STOP_SPEED = 200.f;
+
+// velocity across a cliff face after hitting it: the octopus bats a ball that reaches the coast
+// back faster than it came, a rock just reflects it
+constexpr float BALL_WALL_BOUNCE = -1.5f;
+constexpr float BALL_CLIFF_BOUNCE = -0.5f;
+
+// a ball slower than this has come to rest and expires
+constexpr float BALL_REST_SPEED = 10.f;
+
+// atlas rect of the ball sprite
+constexpr RECT BALL_RECT = { 0, 0, 64, 64 };
+
+// Balls in flight, structure of arrays.
+// Live balls are packed in [0, size()) in launch order, so slot 0 is always the oldest.
+// Storage for PROJECTILE_CAPACITY balls is reserved up front and never reallocates.
+//
+// prevX/prevY hold where each ball was before the current step, for render interpolation.
+//
+// Each step a ball either expires (at rest) or falls under gravity and bounces off its baseline,
+// the row it was thrown from. The integrator runs four balls per SSE2 iteration, with the
+// scalar tail doing the same float ops in the same order. Cliffs are the world's business,
+// it sends balls that ran into one off again through redirect.
+class Projectiles {
+public:
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> vx;
+    std::vector<float> vy;
+    std::vector<float> baseline;
+    std::vector<float> prevX;
+    std::vector<float> prevY;
+
+    Projectiles() {
+        x.reserve(PROJECTILE_CAPACITY);
+        y.reserve(PROJECTILE_CAPACITY);
+        vx.reserve(PROJECTILE_CAPACITY);
+        vy.reserve(PROJECTILE_CAPACITY);
+        baseline.reserve(PROJECTILE_CAPACITY);
+        prevX.reserve(PROJECTILE_CAPACITY);
+        prevY.reserve(PROJECTILE_CAPACITY);
+    }
+
+    // Throw a ball from pos towards dir, false when every slot is taken
+    bool launch(const Vector2 pos, const Vector2 dir) {
+        if (size() >= PROJECTILE_CAPACITY) {
+            return false;
+        }
+        Vector2 velocity;
+        dir.Normalize(velocity);
+        velocity *= BALL_SPEED;
+        x.push_back(pos.x);
+        y.push_back(pos.y);
+        vx.push_back(velocity.x);
+        vy.push_back(velocity.y);
+        baseline.push_back(pos.y);
+        prevX.push_back(pos.x);
+        prevY.push_back(pos.y);
+        return true;
+    }
+
+    void step(const float dt) {
+        expire();
+        integrate(dt);
+    }
+
+    // Put ball i at pos moving at velocity, for collisions resolved after the step
+    void redirect(const size_t i, const Vector2 pos, const Vector2 velocity) {
+        x[i] = pos.x;
+        y[i] = pos.y;
+        vx[i] = velocity.x;
+        vy[i] = velocity.y;
+    }
+
+    // Remember every position before a step moves them
+    void snapshot() {
+        prevX.assign(x.begin(), x.end());
+        prevY.assign(y.begin(), y.end());
+    }
+
+    void clear() {
+        x.clear();
+        y.clear();
+        vx.clear();
+        vy.clear();
+        baseline.clear();
+        prevX.clear();
+        prevY.clear();
+    }
+
+    Vector2 pos(const size_t i) const {
+        return Vector2(x[i], y[i]);
+    }
+
+    Vector2 velocity(const size_t i) const {
+        return Vector2(vx[i], vy[i]);
+    }
+
+    size_t size() const {
+        return x.size();
+    }
+
+    bool empty() const {
+        return x.empty();
+    }
+
+private:
+    // Drop balls at rest, keeping the rest in launch order
+    void expire() {
+        const size_t count = size();
+
+        // nothing moves until the first ball at rest
+        size_t kept = 0;
+        while (kept < count && !atRest(kept)) {
+            ++kept;
+        }
+        if (kept == count) {
+            return;
+        }
+
+        for (size_t i = kept + 1; i < count; ++i) {
+            if (atRest(i)) {
+                continue;
+            }
+            x[kept] = x[i];
+            y[kept] = y[i];
+            vx[kept] = vx[i];
+            vy[kept] = vy[i];
+            baseline[kept] = baseline[i];
+            prevX[kept] = prevX[i];
+            prevY[kept] = prevY[i];
+            ++kept;
+        }
+        x.resize(kept);
+        y.resize(kept);
+        vx.resize(kept);
+        vy.resize(kept);
+        baseline.resize(kept);
+        prevX.resize(kept);
+        prevY.resize(kept);
+    }
+
+    void integrate(const float dt) {
+        const size_t count = size();
+        size_t i = 0;
+
+        // raw pointers so the compiler doesn't reload each vector's data() after every store
+        float* const px0 = x.data();
+        float* const py0 = y.data();
+        float* const pvx0 = vx.data();
+        float* const pvy0 = vy.data();
+        const float* const base0 = baseline.data();
+
+        const __m128 dt4 = _mm_set1_ps(dt);
+        const __m128 gravity = _mm_set1_ps(BALL_GRAVITY);
+        const __m128 bounceX = _mm_set1_ps(BALL_BOUNCE_X);
+        const __m128 bounceY = _mm_set1_ps(BALL_BOUNCE_Y);
+        const __m128 stopSq = _mm_set1_ps(BALL_STOP_SPEED * BALL_STOP_SPEED);
+
+        for (; i + 4 <= count; i += 4) {
+            const __m128 px = _mm_loadu_ps(px0 + i);
+            const __m128 py = _mm_loadu_ps(py0 + i);
+            const __m128 pvx = _mm_loadu_ps(pvx0 + i);
+            const __m128 pvy = _mm_loadu_ps(pvy0 + i);
+            const __m128 base = _mm_loadu_ps(base0 + i);
+
+            // fall
+            __m128 nvx = pvx;
+            __m128 nvy = _mm_add_ps(pvy, gravity);
+            const __m128 nx = _mm_add_ps(px, _mm_mul_ps(nvx, dt4));
+            __m128 ny = _mm_add_ps(py, _mm_mul_ps(nvy, dt4));
+
+            // bounce off the baseline, stopping dead if too slow
+            const __m128 floor = _mm_cmplt_ps(ny, base);
+            ny = select(floor, base, ny);
+            nvx = select(floor, _mm_mul_ps(nvx, bounceX), nvx);
+            nvy = select(floor, _mm_mul_ps(nvy, bounceY), nvy);
+            const __m128 speedSq = _mm_add_ps(_mm_mul_ps(nvx, nvx), _mm_mul_ps(nvy, nvy));
+            const __m128 stop = _mm_and_ps(floor, _mm_cmplt_ps(speedSq, stopSq));
+
+            _mm_storeu_ps(px0 + i, nx);
+            _mm_storeu_ps(py0 + i, ny);
+            _mm_storeu_ps(pvx0 + i, _mm_andnot_ps(stop, nvx));
+            _mm_storeu_ps(pvy0 + i, _mm_andnot_ps(stop, nvy));
+        }
+
+        for (; i < count; ++i) {
+            pvy0[i] = pvy0[i] + BALL_GRAVITY;
+            px0[i] = px0[i] + pvx0[i] * dt;
+            py0[i] = py0[i] + pvy0[i] * dt;
+
+            if (py0[i] < base0[i]) {
+                py0[i] = base0[i];
+                pvx0[i] = pvx0[i] * BALL_BOUNCE_X;
+                pvy0[i] = pvy0[i] * BALL_BOUNCE_Y;
+                if (pvx0[i] * pvx0[i] + pvy0[i] * pvy0[i] < BALL_STOP_SPEED * BALL_STOP_SPEED) {
+                    pvx0[i] = 0.f;
+                    pvy0[i] = 0.f;
+                }
+            }
+        }
+    }
+
+    bool atRest(const size_t i) const {
+        return vx[i] * vx[i] + vy[i] * vy[i] < BALL_REST_SPEED * BALL_REST_SPEED;
+    }
+
+    static __m128 select(const __m128 mask, const __m128 a, const __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "pch.h"
+#include "Chunk.h"
+#include "GridMath.h"
+#include <random>
+#include <unordered_map>
+
+// crabs each resident chunk is kept topped up to
+constexpr int CRABS_PER_CHUNK = 12;
+
+// live crabs allowed in the whole world, so the per-tick cost stays bounded however long the run
+constexpr int CRAB_BUDGET = 256;
+
+// crabs the trickle may add per tick to chunks that have lost some
+constexpr int CRAB_REFILLS_PER_TICK = 1;
+
+// nothing spawns closer than this to the player
+constexpr float SPAWN_CLEARANCE = 512.f;
+
+// Crab population per home chunk, a crab's home being the chunk it stands in.
+// A chunk is filled to CRABS_PER_CHUNK when it becomes resident, from a generator seeded by its
+// coordinate so it fills the same way every visit, then trickle-refilled as crabs get smushed
+// or wander off.
+// The spawner only picks walkable tiles and keeps the books; the caller places the crabs.
+class Spawner {
+public:
+    explicit Spawner(uint32_t seed) : seed(seed), trickle(seed) {}
+
+    // Fill a newly resident chunk with up to count crabs
+    template <typename TChunk, typename TPlace>
+    int populate(const TChunk& chunk, const int count, const TPlace& place) {
+        std::minstd_rand rng(chunkSeed(chunk.coord));
+        return fill(chunk, count, rng, place);
+    }
+
+    // Replace up to count lost crabs in a resident chunk
+    template <typename TChunk, typename TPlace>
+    int refill(const TChunk& chunk, const int count, const TPlace& place) {
+        return fill(chunk, count, trickle, place);
+    }
+
+    int population(const ChunkCoord coord) const {
+        auto it = counts.find(coord);
+        return it == counts.end() ? 0 : it->second;
+    }
+
+    int deficit(const ChunkCoord coord) const {
+        return std::max(CRABS_PER_CHUNK - population(coord), 0);
+    }
+
+    // A crab homed in coord has been released
+    void removed(const ChunkCoord coord) {
+        drop(coord);
+        ++despawned;
+    }
+
+    // A crab homed in from has walked into to
+    void moved(const ChunkCoord from, const ChunkCoord to) {
+        drop(from);
+        ++counts[to];
+    }
+
+    uint64_t spawnCount() const {
+        return spawned;
+    }
+
+    uint64_t despawnCount() const {
+        return despawned;
+    }
+
+private:
+    // Random walkable tiles until count are placed or the attempts run out.
+    // place(column, row) returns false when it can't use the tile.
+    template <typename TChunk, typename TRandom, typename TPlace>
+    int fill(const TChunk& chunk, const int count, TRandom& rng, const TPlace& place) {
+        const auto& walkable = chunk.layers[WalkableLayer];
+        std::uniform_int_distribution<int> tile(0, TChunk::Tiles - 1);
+        int placed = 0;
+        for (int attempt = 0; placed < count && attempt < count * 4; ++attempt) {
+            const int k = tile(rng);
+            const int column = TChunk::columnOf(k);
+            const int row = TChunk::rowOf(k);
+            if (walkable.test(column, row) && place(column, row)) {
+                ++placed;
+            }
+        }
+        if (placed > 0) {
+            counts[chunk.coord] += placed;
+            spawned += placed;
+        }
+        return placed;
+    }
+
+    void drop(const ChunkCoord coord) {
+        auto it = counts.find(coord);
+        if (it != counts.end() && --it->second <= 0) {
+            counts.erase(it);
+        }
+    }
+
+    uint32_t chunkSeed(const ChunkCoord coord) const {
+        return seed ^ hashCell(coord.x, coord.y);
+    }
+
+    uint32_t seed;
+    std::minstd_rand trickle;
+    std::unordered_map<ChunkCoord, int, ChunkCoordHash> counts;
+    uint64_t spawned = 0;
+    uint64_t despawned = 0;
+};
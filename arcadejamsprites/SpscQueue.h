@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Fixed capacity lock-free ring for exactly one producer thread and one consumer thread.
+// The producer owns tail, the consumer owns head; each publishes with release and
+// reads the other's index with acquire, so an item is fully written before it is seen.
+template <typename T, size_t Capacity>
+class SpscQueue {
+public:
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+    // Producer side, false when the ring is full
+    bool push(const T& item) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        m_items[tail & (Capacity - 1)] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, false when the ring is empty
+    bool pop(T& item) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = m_items[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T, Capacity> m_items;
+
+    // padded apart so the two threads don't share a cache line, without
+    // over-aligning the owner (Game is heap allocated)
+    char m_pad0[64];
+    std::atomic<size_t> m_head{ 0 };
+    char m_pad1[64];
+    std::atomic<size_t> m_tail{ 0 };
+};
@@ -4,40 +4,86 @@
 
 #pragma once
 
+#include <chrono>
 #include <cmath>
 #include <cstdint>
-#include <exception>
 
 
 namespace DX
 {
+    // Monotonic counter a StepTimer reads time from, running at Frequency() counts per second.
+    class StepClock
+    {
+    public:
+        virtual ~StepClock() = default;
+
+        virtual uint64_t Frequency() const noexcept = 0;
+        virtual uint64_t Now() const noexcept = 0;
+    };
+
+    // Wall time from std::chrono::steady_clock, which is QueryPerformanceCounter on Windows
+    // and clock_gettime(CLOCK_MONOTONIC) on Linux. Stateless, so one instance serves every timer.
+    class SteadyStepClock final : public StepClock
+    {
+    public:
+        // Counts in StepTimer's canonical 100 ns ticks, so Tick converts deltas exactly. Finer
+        // units would lose the remainder of every delta, all of it when Tick runs in a tight loop.
+        uint64_t Frequency() const noexcept override { return 10000000; }
+
+        uint64_t Now() const noexcept override
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<Ticks>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        static SteadyStepClock& Instance() noexcept
+        {
+            static SteadyStepClock clock;
+            return clock;
+        }
+
+    private:
+        typedef std::chrono::duration<int64_t, std::ratio<1, 10000000>> Ticks;
+    };
+
+    // Time that only moves when advanced, for headless runs. Stepping it by exactly the fixed
+    // timestep before each Tick gives one Update per Tick with bit-identical elapsed and total
+    // times on every run and machine, as fast as the updates themselves can go.
+    class VirtualStepClock final : public StepClock
+    {
+    public:
+        // Counts in StepTimer's canonical ticks, so advancing by a timer's target is exact.
+        uint64_t Frequency() const noexcept override { return 10000000; }
+        uint64_t Now() const noexcept override { return m_now; }
+
+        void Advance(uint64_t ticks) noexcept { m_now += ticks; }
+
+    private:
+        uint64_t m_now = 0;
+    };
+
     // Helper class for animation and simulation timing.
     class StepTimer
     {
     public:
-        StepTimer() noexcept(false) :
+        // Reads the wall clock unless given another; the clock must outlive the timer.
+        explicit StepTimer(const StepClock& clock = SteadyStepClock::Instance()) noexcept :
+            m_clock(&clock),
             m_elapsedTicks(0),
             m_totalTicks(0),
             m_leftOverTicks(0),
             m_frameCount(0),
             m_framesPerSecond(0),
             m_framesThisSecond(0),
-            m_qpcSecondCounter(0),
+            m_clockSecondCounter(0),
             m_isFixedTimeStep(false),
             m_targetElapsedTicks(TicksPerSecond / 60)
         {
-            if (!QueryPerformanceFrequency(&m_qpcFrequency))
-            {
-                throw std::exception();
-            }
-
-            if (!QueryPerformanceCounter(&m_qpcLastTime))
-            {
-                throw std::exception();
-            }
+            m_clockFrequency = m_clock->Frequency();
+            m_clockLastTime = m_clock->Now();
 
             // Initialize max delta to 1/10 of a second.
-            m_qpcMaxDelta = static_cast<uint64_t>(m_qpcFrequency.QuadPart / 10);
+            m_clockMaxDelta = m_clockFrequency / 10;
         }
 
         // Get elapsed time since the previous Update call.
@@ -54,6 +100,13 @@ namespace DX
         // Get the current framerate.
         uint32_t GetFramesPerSecond() const noexcept { return m_framesPerSecond; }
 
+        // Get how far time has run into the next fixed timestep, from 0 up to 1, for blending the
+        // previous and current simulation states when rendering. Always 1 in variable timestep mode.
+        double GetInterpolation() const noexcept
+        {
+            return m_isFixedTimeStep ? static_cast<double>(m_leftOverTicks) / m_targetElapsedTicks : 1.0;
+        }
+
         // Set whether to use fixed or variable timestep mode.
         void SetFixedTimeStep(bool isFixedTimestep) noexcept { m_isFixedTimeStep = isFixedTimestep; }
 
@@ -71,17 +124,14 @@ namespace DX
         // call this to avoid having the fixed timestep logic attempt a set of catch-up
         // Update calls.
 
-        void ResetElapsedTime()
+        void ResetElapsedTime() noexcept
         {
-            if (!QueryPerformanceCounter(&m_qpcLastTime))
-            {
-                throw std::exception();
-            }
+            m_clockLastTime = m_clock->Now();
 
             m_leftOverTicks = 0;
             m_framesPerSecond = 0;
             m_framesThisSecond = 0;
-            m_qpcSecondCounter = 0;
+            m_clockSecondCounter = 0;
         }
 
         // Update timer state, calling the specified Update function the appropriate number of times.
@@ -89,27 +139,22 @@ namespace DX
         void Tick(const TUpdate& update)
         {
             // Query the current time.
-            LARGE_INTEGER currentTime;
-
-            if (!QueryPerformanceCounter(&currentTime))
-            {
-                throw std::exception();
-            }
+            const uint64_t currentTime = m_clock->Now();
 
-            uint64_t timeDelta = static_cast<uint64_t>(currentTime.QuadPart - m_qpcLastTime.QuadPart);
+            uint64_t timeDelta = currentTime - m_clockLastTime;
 
-            m_qpcLastTime = currentTime;
-            m_qpcSecondCounter += timeDelta;
+            m_clockLastTime = currentTime;
+            m_clockSecondCounter += timeDelta;
 
             // Clamp excessively large time deltas (e.g. after paused in the debugger).
-            if (timeDelta > m_qpcMaxDelta)
+            if (timeDelta > m_clockMaxDelta)
             {
-                timeDelta = m_qpcMaxDelta;
+                timeDelta = m_clockMaxDelta;
             }
 
-            // Convert QPC units into a canonical tick format. This cannot overflow due to the previous clamp.
+            // Convert clock units into a canonical tick format. This cannot overflow due to the previous clamp.
             timeDelta *= TicksPerSecond;
-            timeDelta /= static_cast<uint64_t>(m_qpcFrequency.QuadPart);
+            timeDelta /= m_clockFrequency;
 
             const uint32_t lastFrameCount = m_frameCount;
 
@@ -158,19 +203,20 @@ namespace DX
                 m_framesThisSecond++;
             }
 
-            if (m_qpcSecondCounter >= static_cast<uint64_t>(m_qpcFrequency.QuadPart))
+            if (m_clockSecondCounter >= m_clockFrequency)
             {
                 m_framesPerSecond = m_framesThisSecond;
                 m_framesThisSecond = 0;
-                m_qpcSecondCounter %= static_cast<uint64_t>(m_qpcFrequency.QuadPart);
+                m_clockSecondCounter %= m_clockFrequency;
             }
         }
 
     private:
-        // Source timing data uses QPC units.
-        LARGE_INTEGER m_qpcFrequency;
-        LARGE_INTEGER m_qpcLastTime;
-        uint64_t m_qpcMaxDelta;
+        // Source timing data uses the clock's units.
+        const StepClock* m_clock;
+        uint64_t m_clockFrequency;
+        uint64_t m_clockLastTime;
+        uint64_t m_clockMaxDelta;
 
         // Derived timing data uses a canonical tick format.
         uint64_t m_elapsedTicks;
@@ -181,7 +227,7 @@ namespace DX
         uint32_t m_frameCount;
         uint32_t m_framesPerSecond;
         uint32_t m_framesThisSecond;
-        uint64_t m_qpcSecondCounter;
+        uint64_t m_clockSecondCounter;
 
         // Members for configuring fixed timestep mode.
         bool m_isFixedTimeStep;
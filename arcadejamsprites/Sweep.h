@@ -0,0 +1,59 @@
+#pragma once
+
+#include "pch.h"
+#include <algorithm>
+
+using namespace DirectX::SimpleMath;
+
+// Continuous box test: a size x size box with its min corner moving from from to from + delta
+// against the fixed box [boxMin, boxMax). Boxes are half-open like World::checkForCollision,
+// so touching edges don't count. On a hit toi is the fraction of delta travelled before the
+// boxes first overlap, 0 when they already do, and hitAxis is the axis (0 x, 1 y) whose faces
+// met last, i.e. the one to reflect on, or -1 when they already overlap.
+//
+// The moving corner is swept as a point through boxMin - size .. boxMax (the Minkowski sum),
+// clipping the entry and exit times axis by axis.
+inline bool sweepBox(const Vector2 from, const Vector2 delta, const float size,
+    const Vector2 boxMin, const Vector2 boxMax, float& toi, int& hitAxis) {
+    float enter = 0.f;
+    float exit = 1.f;
+    int enterAxis = -1;
+
+    const float start[2] = { from.x, from.y };
+    const float move[2] = { delta.x, delta.y };
+    const float lo[2] = { boxMin.x - size, boxMin.y - size };
+    const float hi[2] = { boxMax.x, boxMax.y };
+    for (int axis = 0; axis < 2; ++axis) {
+        if (move[axis] == 0.f) {
+            // parallel to this slab, inside it for the whole move or never
+            if (start[axis] <= lo[axis] || start[axis] >= hi[axis]) {
+                return false;
+            }
+            continue;
+        }
+        float t0 = (lo[axis] - start[axis]) / move[axis];
+        float t1 = (hi[axis] - start[axis]) / move[axis];
+        if (t0 > t1) {
+            std::swap(t0, t1);
+        }
+        // >= so a box starting flush against a face still reports that face
+        if (t0 >= enter) {
+            enter = t0;
+            enterAxis = axis;
+        }
+        exit = std::min(exit, t1);
+        if (enter >= exit) {
+            return false;
+        }
+    }
+
+    toi = enter;
+    hitAxis = enterAxis;
+    return true;
+}
+
+inline bool sweepBox(const Vector2 from, const Vector2 delta, const float size,
+    const Vector2 boxMin, const Vector2 boxMax, float& toi) {
+    int axis;
+    return sweepBox(from, delta, size, boxMin, boxMax, toi, axis);
+}
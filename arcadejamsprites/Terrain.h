@@ -0,0 +1,166 @@
+#pragma once
+
+#include "pch.h"
+#include "Chunk.h"
+#include "GridMath.h"
+#include <climits>
+#include <emmintrin.h>
+
+// default world seed
+constexpr uint32_t WORLD_SEED = 1069345;
+
+// column where the water meets the cliff before the coastline noise pulls it west
+constexpr int SHORE_COLUMN = 20;
+
+// how many columns the coast can move west of SHORE_COLUMN, and over how many rows it wanders
+constexpr int COAST_AMPLITUDE = 4;
+constexpr int COAST_PERIOD = 8;
+
+// 2D noise lattice spacing in tiles, a multiple of the 4 SSE lanes so a lane group never straddles a cell
+constexpr int NOISE_CELL = 8;
+
+// rock outcrops start this far east of SHORE_COLUMN so the spawn beach stays open
+constexpr int ROCK_MARGIN = 4;
+constexpr float ROCK_THRESHOLD = 0.8f;
+
+// tide pools sit in the sand within this many columns of the cliff
+constexpr int POOL_REACH = 10;
+constexpr float POOL_THRESHOLD = 0.72f;
+
+// Seeded value-noise terrain. Each chunk's solid, water and walkable layers are a pure
+// function of (seed, chunk coordinate): only integer hashing and a fixed sequence of float ops
+// are involved, so any thread produces the same bits. Lattice values are hashed per row and the
+// per-tile interpolation and thresholding run four columns at a time in SSE2, with compare
+// masks going straight into the layer bitmaps.
+class Terrain {
+public:
+    explicit Terrain(uint32_t seed) : seed(seed) {}
+
+    template <int Width, int Height>
+    void fillLayers(std::array<TileMask<Width, Height>, LayerCount>& layers, const ChunkCoord coord) const {
+        static_assert(Width % NOISE_CELL == 0, "chunks must hold whole noise cells");
+        static_assert(NOISE_CELL % 4 == 0, "noise cells must hold whole lane groups");
+
+        constexpr int Cells = Width / NOISE_CELL;
+        constexpr uint64_t RowBits = Width == 64 ? ~0ull : (1ull << Width) - 1;
+
+        for (auto& layer : layers) {
+            layer.clear();
+        }
+
+        const int column0 = Chunk<Width, Height>::globalColumn(coord, 0);
+        const int cell0 = column0 / NOISE_CELL;
+
+        // smoothstep of the lane offsets inside a cell, for the first and second lane group
+        const __m128 fadeLo = fade4(_mm_setr_ps(0.f, 1.f, 2.f, 3.f));
+        const __m128 fadeHi = fade4(_mm_setr_ps(4.f, 5.f, 6.f, 7.f));
+
+        float rock[Cells + 1];
+        float pool[Cells + 1];
+
+        for (int row = 0; row < Height; ++row) {
+            const int globalRow = Chunk<Width, Height>::globalRow(coord, row);
+
+            // coastline, with the cliff filling the step from the previous row so it never has gaps
+            const int shore = coastColumn(globalRow);
+            const int shorePrev = coastColumn(globalRow - 1);
+            const int cliffMin = std::min(shore, shorePrev);
+            const int cliffMax = std::max(shore, shorePrev);
+
+            const uint64_t water = spanBits(INT_MIN / 2, cliffMin - 1, column0, Width);
+            const uint64_t cliff = spanBits(cliffMin, cliffMax, column0, Width);
+            const uint64_t sand = RowBits & ~(water | cliff);
+
+            // lattice values for this row, interpolated vertically
+            latticeRow(rock, Cells + 1, cell0, globalRow, seed ^ 0x9e3779b9u);
+            latticeRow(pool, Cells + 1, cell0, globalRow, seed ^ 0x7f4a7c15u);
+
+            uint64_t rockBits = 0;
+            uint64_t poolBits = 0;
+            const __m128 rockCut = _mm_set1_ps(ROCK_THRESHOLD);
+            const __m128 poolCut = _mm_set1_ps(POOL_THRESHOLD);
+            for (int group = 0; group < Width / 4; ++group) {
+                const int cell = group * 4 / NOISE_CELL;
+                const __m128 fade = (group & 1) ? fadeHi : fadeLo;
+                const __m128 rock4 = lerp4(rock[cell], rock[cell + 1], fade);
+                const __m128 pool4 = lerp4(pool[cell], pool[cell + 1], fade);
+                rockBits |= static_cast<uint64_t>(_mm_movemask_ps(_mm_cmpgt_ps(rock4, rockCut))) << (group * 4);
+                poolBits |= static_cast<uint64_t>(_mm_movemask_ps(_mm_cmpgt_ps(pool4, poolCut))) << (group * 4);
+            }
+
+            rockBits &= sand & spanBits(SHORE_COLUMN + ROCK_MARGIN, INT_MAX / 2, column0, Width);
+            poolBits &= sand & ~rockBits & spanBits(cliffMax + 2, cliffMax + POOL_REACH, column0, Width);
+
+            layers[SolidLayer].rows[row] = cliff | rockBits;
+            layers[WaterLayer].rows[row] = water | poolBits;
+            layers[WalkableLayer].rows[row] = sand & ~(rockBits | poolBits);
+        }
+    }
+
+    // Global column of the cliff on a global row
+    int coastColumn(const int globalRow) const {
+        const int cell = floorDiv(globalRow, COAST_PERIOD);
+        const float t = fade((globalRow - cell * COAST_PERIOD) / static_cast<float>(COAST_PERIOD));
+        const float a = unit(hash(static_cast<uint32_t>(cell) ^ seed));
+        const float b = unit(hash(static_cast<uint32_t>(cell + 1) ^ seed));
+        return SHORE_COLUMN - static_cast<int>((a + (b - a) * t) * (COAST_AMPLITUDE + 1));
+    }
+
+private:
+    // Bob Jenkins' 32-bit integer hash, adds, xors and shifts only so SSE2 could run it too
+    static uint32_t hash(uint32_t a) {
+        a = (a + 0x7ed55d16u) + (a << 12);
+        a = (a ^ 0xc761c23cu) ^ (a >> 19);
+        a = (a + 0x165667b1u) + (a << 5);
+        a = (a + 0xd3a2646cu) ^ (a << 9);
+        a = (a + 0xfd7046c5u) + (a << 3);
+        a = (a ^ 0xb55a4f09u) ^ (a >> 16);
+        return a;
+    }
+
+    static uint32_t hash2(const int x, const int y, const uint32_t salt) {
+        return hash(static_cast<uint32_t>(x) + hash(static_cast<uint32_t>(y) ^ salt));
+    }
+
+    // top 24 bits of a hash as a float in [0, 1)
+    static float unit(const uint32_t h) {
+        return static_cast<float>(h >> 8) * (1.f / 16777216.f);
+    }
+
+    static float fade(const float t) {
+        return t * t * (3.f - 2.f * t);
+    }
+
+    static __m128 fade4(const __m128 offset) {
+        const __m128 t = _mm_mul_ps(offset, _mm_set1_ps(1.f / NOISE_CELL));
+        return _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(_mm_set1_ps(3.f), _mm_add_ps(t, t)));
+    }
+
+    static __m128 lerp4(const float a, const float b, const __m128 t) {
+        return _mm_add_ps(_mm_set1_ps(a), _mm_mul_ps(_mm_set1_ps(b - a), t));
+    }
+
+    // Value noise at every lattice column cell0.. on a global row
+    static void latticeRow(float* out, const int count, const int cell0, const int globalRow, const uint32_t salt) {
+        const int cellY = floorDiv(globalRow, NOISE_CELL);
+        const float t = fade((globalRow - cellY * NOISE_CELL) / static_cast<float>(NOISE_CELL));
+        for (int i = 0; i < count; ++i) {
+            const float a = unit(hash2(cell0 + i, cellY, salt));
+            const float b = unit(hash2(cell0 + i, cellY + 1, salt));
+            out[i] = a + (b - a) * t;
+        }
+    }
+
+    // Bits of a chunk row covering global columns [first, last]
+    static uint64_t spanBits(const int first, const int last, const int column0, const int width) {
+        const int lo = std::max(first - column0, 0);
+        const int hi = std::min(last - column0, width - 1);
+        if (lo > hi) {
+            return 0;
+        }
+        const int span = hi - lo + 1;
+        return (span >= 64 ? ~0ull : (1ull << span) - 1) << lo;
+    }
+
+    uint32_t seed;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "pch.h"
+#include <array>
+
+// Bit count without needing POPCNT support on the target CPU
+inline int popcount64(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return static_cast<int>((x * 0x0101010101010101ull) >> 56);
+}
+
+// Packed one-bit-per-tile attribute map, one 64-bit word per tile row.
+// Rect queries are a column mask ANDed against each covered row.
+template <int Width, int Height>
+struct TileMask {
+    static_assert(Width <= 64, "a tile row must fit in one word");
+
+    std::array<uint64_t, Height> rows;
+
+    void clear() {
+        rows.fill(0);
+    }
+
+    void set(const int column, const int row) {
+        rows[row] |= 1ull << column;
+    }
+
+    // Is every tile set
+    bool full() const {
+        const uint64_t all = Width == 64 ? ~0ull : (1ull << Width) - 1;
+        for (const uint64_t bits : rows) {
+            if (bits != all) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool test(const int column, const int row) const {
+        return (rows[row] >> column) & 1ull;
+    }
+
+    // Is any bit set in the inclusive column/row range
+    bool any(const int columnMin, const int columnMax, const int rowMin, const int rowMax) const {
+        const uint64_t mask = spanMask(columnMin, columnMax);
+        uint64_t hits = 0;
+        for (int row = rowMin; row <= rowMax; ++row) {
+            hits |= rows[row] & mask;
+        }
+        return hits != 0;
+    }
+
+    // Number of set bits in the inclusive column/row range
+    int count(const int columnMin, const int columnMax, const int rowMin, const int rowMax) const {
+        const uint64_t mask = spanMask(columnMin, columnMax);
+        int total = 0;
+        for (int row = rowMin; row <= rowMax; ++row) {
+            total += popcount64(rows[row] & mask);
+        }
+        return total;
+    }
+
+    static uint64_t spanMask(const int columnMin, const int columnMax) {
+        const int span = columnMax - columnMin + 1;
+        const uint64_t bits = span >= 64 ? ~0ull : (1ull << span) - 1;
+        return bits << columnMin;
+    }
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "pch.h"
+#include <atomic>
+
+// Latest-value mailbox between one writer thread and one reader thread, over three slots.
+// The writer fills back() and publishes it, the reader takes whichever slot was published last.
+// The middle slot changes hands through a single atomic exchange, so neither side ever waits or
+// sees a slot the other is using. Unread values are overwritten, the reader only sees the newest.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer: the slot to fill, still holding whatever it held three publishes ago
+    T& back() {
+        return slots[backIndex];
+    }
+
+    // Writer: hand the filled slot over and take the idle one back
+    void publish() {
+        backIndex = shared.exchange(static_cast<uint8_t>(backIndex | Fresh), std::memory_order_acq_rel) & IndexMask;
+    }
+
+    // Reader: the newest published slot, or the one read last time if nothing new came in
+    const T& latest() {
+        if (shared.load(std::memory_order_relaxed) & Fresh) {
+            frontIndex = shared.exchange(frontIndex, std::memory_order_acq_rel) & IndexMask;
+        }
+        return slots[frontIndex];
+    }
+
+private:
+    static constexpr uint8_t IndexMask = 3;
+    static constexpr uint8_t Fresh = 4;
+
+    T slots[3];
+    uint8_t backIndex = 0;
+    uint8_t frontIndex = 1;
+    std::atomic<uint8_t> shared{ 2 };
+};
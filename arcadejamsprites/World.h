@@ -1,180 +1,541 @@
+#pragma once
+
 #include "pch.h"
 #include "Descriptors.h"
 #include "Animals.h"
 #include <random>
+#include <array>
 #include "Components.h"
+#include "ChunkManager.h"
+#include "Chunk.h"
+#include "Terrain.h"
+#include "ChunkCache.h"
+#include "Pool.h"
+#include "Herds.h"
+#include "Spawner.h"
+#include "Broadphase.h"
+#include "Projectiles.h"
+#include "Sweep.h"
+#include "GridMath.h"
 
 using namespace DirectX;
 using namespace DirectX::SimpleMath;
 
-constexpr int CHUNK_WIDTH = 10;
-constexpr int CHUNK_HEIGHT = 10;
+// chunk dimensions in tiles, fixed at compile time through Chunk<W, H>
+constexpr int CHUNK_WIDTH = 40;
+constexpr int CHUNK_HEIGHT = 20;
+
+// world units per tile, a 32px atlas cell drawn at 4x
 constexpr int TILE_SCALE = 32 * 4;
-constexpr int SPEED = 2;
 
-constexpr float RESISTANCE_C = 0.9f;
+// left edge of the beach at the default window width
+constexpr float WORLD_ORIGIN_X = -1920 * 1.55f;
 
+// chunk cache file, next to the executable's resources
+constexpr const wchar_t* CHUNK_CACHE_PATH = L"./world.chunks";
 
-class Rand_int {
-public:
-    Rand_int(int low, int high) :dist{ low, high } {}
-    int operator()() { return dist(re); }
-    void seed(int s) { re.seed(s); }
-private:
-    std::default_random_engine re;
-    std::uniform_int_distribution<> dist;
+// chunks kept resident on each side of the camera's chunk
+constexpr int CHUNK_RADIUS_X = 1;
+constexpr int CHUNK_RADIUS_Y = 1;
+
+// Atlas rect of each terrain tile, indexed by Descriptors
+constexpr RECT TILE_RECTS[Descriptors::Count] = {
+    { 0, 0, 0, 0 },         // Cat
+    { 0, 0, 0, 0 },         // Ball
+    { 32, 32, 64, 64 },     // Sand
+    { 876, 128, 912, 160 }, // Cliff
+    { 0, 0, 0, 0 },         // Crab
+    { 0, 0, 0, 0 },         // Octo
+    { 700, 0, 732, 32 },    // Water
+    { 0, 0, 0, 0 },         // MyFont
 };
+static_assert(Descriptors::Count == 8, "TILE_RECTS needs a rect for every descriptor");
+
+// how far a terrain sprite reaches right of and below its anchor at the 4x draw scale,
+// the cliff's 36px cell being the widest
+constexpr float TILE_DRAW_WIDTH = (TILE_RECTS[Cliff].right - TILE_RECTS[Cliff].left) * 4.f;
+constexpr float TILE_DRAW_HEIGHT = TILE_SCALE;
+
+// extent of a cliff tile's hitbox, narrower than the tile it is drawn on
+constexpr int CLIFF_HITBOX = 32 * 2;
+
+// extent of crab, dog and ball hitboxes
+constexpr int ENTITY_HITBOX = 36;
+static_assert(ENTITY_HITBOX * 2 <= BROADPHASE_CELL, "a hitbox query must stay within 2x2 broadphase cells");
+
+// most animals alive at once, crabs and the octopus alike, unless a World is built with more
+constexpr uint32_t ANIMAL_CAPACITY = 1024;
+
+// ball candidate pairs tested per job
+constexpr size_t BALL_HIT_GRAIN = 64;
+
+
 
 class World {
 public:
 
-    struct Tile {
-        Descriptors desc = Sand;
-        Vector2 pos = Vector2(0.f, 0.f);
-        RECT rect = RECT{ 0,0,0,0};
-
-        boolean gapCheckVs(const Vector3& newPos) const {
-            int TILE_SCALE = 32 * 2;
-            if (pos.x < newPos.x + TILE_SCALE &&
-                pos.x + TILE_SCALE > newPos.x &&
-                pos.y < newPos.y + TILE_SCALE &&
-                pos.y + TILE_SCALE > newPos.y
-                ) {
-                return true;
+    typedef ::Chunk<CHUNK_WIDTH, CHUNK_HEIGHT> Chunk;
+
+    const Terrain terrain{ WORLD_SEED };
+
+    // Background while playing; Inline for headless runs, which must replay bit for bit
+    const ChunkGeneration generation;
+
+    // declared ahead of chunks so it outlives the chunk worker
+    ChunkCache<Chunk> cache;
+
+    ChunkManager<Chunk> chunks{ CHUNK_RADIUS_X, CHUNK_RADIUS_Y,
+        [this](Chunk& chunk, const ChunkCoord coord) {
+            if (!cache.load(chunk, coord)) {
+                generateChunkAt(terrain, chunk, coord);
             }
-            else {
-                return false;
+        },
+        [this](const Chunk& chunk) {
+            cache.store(chunk);
+            evictedChunks.push_back(chunk.coord);
+        },
+        [this](const Chunk& chunk) {
+            admittedChunks.push_back(chunk.coord);
+        },
+        generation };
+
+    // chunks that left or joined the window since the last settleChunks, so streaming never touches the herds
+    std::vector<ChunkCoord> evictedChunks;
+    std::vector<ChunkCoord> admittedChunks;
+
+    Projectiles balls;
+    Pool<Animal> animalPool;
+    // live animals grouped by type, each herd advanced by its HERD_BEHAVIORS entry
+    std::array<Herd, Descriptors::Count> herds;
+
+    // handle registry; hold an animal's Entity rather than its pointer past the end of a tick
+    Entities entities;
+    ComponentStore<Animal*> animalByEntity;
+
+    // chunk each crab stood in as of the last rehomeCrabs, it leaves with that chunk
+    Spawner spawner{ WORLD_SEED };
+    ComponentStore<ChunkCoord> homeChunk;
+
+    // crab positions bucketed for collision queries, and the pairs it produced this tick
+    Broadphase crabGrid;
+    std::vector<CandidatePair> crabPairs;
+    std::vector<uint8_t> ballHits;
+
+    // capacity bounds the animal pool; the game keeps ANIMAL_CAPACITY, stress runs go bigger
+    explicit World(const ChunkGeneration generation = ChunkGeneration::Background, const uint32_t capacity = ANIMAL_CAPACITY) :
+        generation(generation),
+        animalPool(capacity)
+    {
+        herds[Crab].reserve(capacity);
+        entities.reserve(capacity);
+        animalByEntity.reserve(capacity);
+        homeChunk.reserve(CRAB_BUDGET);
+        createAnimal(Octo, Vector2(coastX(0.f) - OCTO_SHORE_OFFSET, 0.f));
+        // a headless world leaves the player's chunk cache alone
+        if (generation == ChunkGeneration::Background) {
+            cache.open(CHUNK_CACHE_PATH, WORLD_SEED);
+        }
+        streamChunks(Vector3(0.f, 0.f, 0.f));
+        settleChunks();
+    }
+
+    ~World() {
+
+        // keep what is on screen for the next run
+        chunks.forEach([this](const Chunk& chunk) {
+            cache.store(chunk);
+        });
+
+        // return animals to the pool
+        for (auto &herd : herds) {
+            for (auto &a : herd.members) {
+                animalPool.destroy(a);
             }
         }
+    }
+
+    static ChunkCoord chunkAt(const Vector3& pos) {
+        return ChunkCoord{
+            static_cast<int>(std::floor((pos.x - WORLD_ORIGIN_X) / (CHUNK_WIDTH * TILE_SCALE))),
+            static_cast<int>(std::floor(pos.y / (CHUNK_HEIGHT * TILE_SCALE)))
+        };
+    }
+
+    // Global tile cell holding a world position, tiles are anchored at their min corner
+    static int tileColumn(const float x) {
+        return static_cast<int>(std::floor((x - WORLD_ORIGIN_X) / TILE_SCALE));
+    }
+
+    static int tileRow(const float y) {
+        return static_cast<int>(std::floor(y / TILE_SCALE));
+    }
+
+    // Last global tile cell anchored strictly before a world position
+    static int tileColumnBefore(const float x) {
+        return static_cast<int>(std::ceil((x - WORLD_ORIGIN_X) / TILE_SCALE)) - 1;
+    }
+
+    static int tileRowBefore(const float y) {
+        return static_cast<int>(std::ceil(y / TILE_SCALE)) - 1;
+    }
+
+    // Inclusive range of global tile cells
+    struct TileRange {
+        int columnMin;
+        int columnMax;
+        int rowMin;
+        int rowMax;
     };
 
-    struct Projectile : Tile {
-        Vector2 velocity;
-        float baselineY;
-        RECT rect = { 0, 0, 64, 64 };
-
-        Projectile(Descriptors descr, Vector2 posi, Vector2 vel) {
-            desc = descr;
-            pos = posi;
-            vel.Normalize(velocity);
-            velocity *= SPEED * 100.f * 10.f;
-            baselineY = posi.y;
-        }
-
-        void update(const float& delta) {
-            this->velocity = velocity + Vector2(0.f, -9.8f * SPEED) * RESISTANCE_C;
-            this->pos += velocity * delta;
-
-            if (pos.y < baselineY) {
-                
-                pos.y = baselineY;
-                velocity.y = -velocity.y * 0.4f;
-                velocity.x = velocity.x * 0.5f;
-                if (velocity.Length() < 200.f) {
-                    velocity = Vector2(0.f, 0.f);
+    // Cells whose sprite can land inside a width x height window centered on the camera.
+    // Sprites are drawn at offset + camera - pos and reach right and down from there, so a tile is
+    // on screen while its anchor is within half a window of the camera, plus the sprite's extent on the far side.
+    static TileRange visibleTiles(const Vector3& cameraPos, const int width, const int height) {
+        const float halfWidth = width / 2.f;
+        const float halfHeight = height / 2.f;
+        return TileRange{
+            tileColumn(cameraPos.x - halfWidth), tileColumnBefore(cameraPos.x + halfWidth + TILE_DRAW_WIDTH),
+            tileRow(cameraPos.y - halfHeight), tileRowBefore(cameraPos.y + halfHeight + TILE_DRAW_HEIGHT)
+        };
+    }
+
+    // Split an inclusive range of global tile cells across the resident chunks it covers.
+    // visit is called as visit(chunk, columnMin, columnMax, rowMin, rowMax) in chunk-local cells
+    // and returns true to stop early.
+    template <typename TVisit>
+    bool forEachChunkInCells(const TileRange& cells, const TVisit& visit) const {
+        const int columnMin = cells.columnMin;
+        const int columnMax = cells.columnMax;
+        const int rowMin = cells.rowMin;
+        const int rowMax = cells.rowMax;
+        if (columnMin > columnMax || rowMin > rowMax) {
+            return false;
+        }
+
+        for (int cy = floorDiv(rowMin, CHUNK_HEIGHT); cy <= floorDiv(rowMax, CHUNK_HEIGHT); ++cy) {
+            for (int cx = floorDiv(columnMin, CHUNK_WIDTH); cx <= floorDiv(columnMax, CHUNK_WIDTH); ++cx) {
+                const Chunk* chunk = chunks.find(ChunkCoord{ cx, cy });
+                if (!chunk) {
+                    continue;
+                }
+                const int baseColumn = cx * CHUNK_WIDTH;
+                const int baseRow = cy * CHUNK_HEIGHT;
+                if (visit(*chunk,
+                    std::max(columnMin - baseColumn, 0), std::min(columnMax - baseColumn, CHUNK_WIDTH - 1),
+                    std::max(rowMin - baseRow, 0), std::min(rowMax - baseRow, CHUNK_HEIGHT - 1))) {
+                    return true;
                 }
             }
         }
-    };
+        return false;
+    }
 
-    std::vector<Tile*> tiles;
-    std::vector<Projectile*> projectiles;
-    std::vector<Animal*> animals;
-    std::unique_ptr<Octoc> octo;
+    // Is any tile on layer under the world rect [min, max), tiles counted by their full cell
+    boolean anyTileUnder(const TileLayer layer, const Vector2& min, const Vector2& max) const {
+        const TileRange cells{ tileColumn(min.x), tileColumnBefore(max.x), tileRow(min.y), tileRowBefore(max.y) };
+        return forEachChunkInCells(cells,
+            [layer](const Chunk& chunk, int c0, int c1, int r0, int r1) {
+                return chunk.layers[layer].any(c0, c1, r0, r1);
+            });
+    }
 
-    World() {
-        generateChunkAt(-1100,0);
-        newCrabs(40);
-        
-        octo = std::make_unique<Octoc>();
-        Entities *e = new Entities;
+    // Number of tiles on layer under the world rect [min, max)
+    int countTilesUnder(const TileLayer layer, const Vector2& min, const Vector2& max) const {
+        int total = 0;
+        const TileRange cells{ tileColumn(min.x), tileColumnBefore(max.x), tileRow(min.y), tileRowBefore(max.y) };
+        forEachChunkInCells(cells,
+            [layer, &total](const Chunk& chunk, int c0, int c1, int r0, int r1) {
+                total += chunk.layers[layer].count(c0, c1, r0, r1);
+                return false;
+            });
+        return total;
     }
 
-    ~World() {
+    // Keep the chunk window centered on the camera, recycling chunks left behind
+    // and prefetching the next band in the direction the camera last moved
+    void streamChunks(const Vector3& cameraPos) {
+        const float dx = cameraPos.x - lastCameraPos.x;
+        const float dy = cameraPos.y - lastCameraPos.y;
+        if (dx != 0.f) {
+            heading.x = dx > 0.f ? 1 : -1;
+        }
+        if (dy != 0.f) {
+            heading.y = dy > 0.f ? 1 : -1;
+        }
+        lastCameraPos = cameraPos;
+
+        chunks.streamAround(chunkAt(cameraPos), heading);
+    }
 
-        // delete tiles
-        for (auto &t : this->tiles) {
-            delete t;
+    // Runs on the chunk worker thread, touches nothing but the chunk.
+    // The terrain decides the layers and the tile types follow from them.
+    // Any Chunk<W, H> will do, so other chunk sizes can be measured against this one.
+    template <typename TChunk>
+    static void generateChunkAt(const Terrain& terrain, TChunk& chunk, const ChunkCoord coord) {
+        chunk.coord = coord;
+        terrain.fillLayers(chunk.layers, coord);
+
+        // open water, bare sand or solid rock collapse to a single palette entry
+        if (chunk.layers[WaterLayer].full()) {
+            chunk.setUniform(Water);
+            return;
+        }
+        if (chunk.layers[WalkableLayer].full()) {
+            chunk.setUniform(Sand);
+            return;
         }
+        if (chunk.layers[SolidLayer].full()) {
+            chunk.setUniform(Cliff);
+            return;
+        }
+
+        typename TChunk::TileArray& tiles = chunk.tiles();
+        for (int k = 0; k < TChunk::Tiles; ++k) {
+            const int j = TChunk::columnOf(k);
+            const int i = TChunk::rowOf(k);
 
-        // delete animals
-        for (auto &a : this->animals) {
-            delete a;
+            Descriptors descriptor = Sand;
+            if (chunk.layers[SolidLayer].test(j, i)) {
+                descriptor = Cliff;
+            }
+            else if (chunk.layers[WaterLayer].test(j, i)) {
+                descriptor = Water;
+            }
+            tiles[k] = static_cast<uint8_t>(descriptor);
         }
+    }
+
+    // World position of a tile's min corner
+    static Vector2 tileAnchor(const ChunkCoord coord, const int column, const int row) {
+        return Vector2(
+            WORLD_ORIGIN_X + Chunk::globalColumn(coord, column) * TILE_SCALE,
+            static_cast<float>(Chunk::globalRow(coord, row) * TILE_SCALE));
+    }
+
+    size_t residentChunkCount() const {
+        return chunks.residentCount();
+    }
 
-        // delete ball
-        deleteBall();
+    size_t residentChunkBytes() const {
+        return chunks.residentBytes();
     }
 
-    void newCrabs(int count = 20) {
-        Rand_int rndx{ -400, 1000 };
-        Rand_int rndy{ -1000, 1000 };
-        rndy.seed(4235345);
-        rndx.seed(1069345);
-        for (int i = 0; i < count; ++i) {
-            int x = rndx();
-            int y = rndy();
-            createAnimal(Vector2(x, y));
+    // nullptr when the pool is full
+    Animal* createAnimal(const Descriptors type, const Vector2 pos) {
+        Animal* an = animalPool.create();
+        if (an) {
+            an->type = type;
+            an->id = entities.create();
+            animalByEntity.add(an->id, an);
+            herds[type].push(an, pos);
         }
+        return an;
+    }
+
+    // Top up resident chunks that have lost crabs, a few per tick within the budget
+    void refillCrabs() {
+        int quota = std::min(CRAB_REFILLS_PER_TICK, crabRoom());
+        chunks.forEach([&](const Chunk& chunk) {
+            const int want = std::min(spawner.deficit(chunk.coord), quota);
+            if (want > 0) {
+                quota -= spawner.refill(chunk, want, [this, &chunk](const int column, const int row) {
+                    return placeCrab(chunk.coord, column, row);
+                });
+            }
+        });
     }
 
-    void generateChunkAt(int nx, int ny) {
-        for (int i = 0; i < 20; ++i) {
-            for (int j = 0; j < 40; ++j) {
-                int color = 0;
-                RECT temp_rect = sand_rect;
-                Descriptors descriptor = Sand;
-                if (j == 20) {
-                    temp_rect = shore_rect;
-                    descriptor = Cliff;
+    // Rebuild the crab grid from this tick's positions, before asking for candidates
+    void indexCrabs() {
+        const Herd& crabs = herds[Crab];
+        crabGrid.build(crabs.x.data(), crabs.y.data(), crabs.size());
+    }
+
+    // Crabs each query box may touch
+    const std::vector<CandidatePair>& crabCandidates(const Vector2* queries, const size_t count) {
+        crabPairs.clear();
+        crabGrid.pairs(queries, count, static_cast<float>(ENTITY_HITBOX), crabPairs);
+        return crabPairs;
+    }
+
+    // Crabs each ball may have passed through this step, the query is the ball's slot
+    const std::vector<CandidatePair>& ballCandidates() {
+        crabPairs.clear();
+        crabGrid.sweeps(balls.prevX.data(), balls.prevY.data(), balls.x.data(), balls.y.data(), balls.size(),
+            static_cast<float>(ENTITY_HITBOX), crabPairs);
+        return crabPairs;
+    }
+
+    // Exact sweep test of every ball candidate, spread over jobs. ballHits[k] answers
+    // ballCandidates()[k], so the caller applies the hits in pair order whatever ran where.
+    const std::vector<uint8_t>& testBallCandidates(JobSystem& jobs) {
+        ballHits.resize(crabPairs.size());
+        jobs.parallel_for(0, crabPairs.size(), BALL_HIT_GRAIN, [this](const size_t first, const size_t last) {
+            for (size_t k = first; k < last; ++k) {
+                ballHits[k] = ballHitsCrab(crabPairs[k].query, crabPairs[k].entity) ? 1 : 0;
+            }
+        });
+        return ballHits;
+    }
+
+    // Did ball's path this step overlap the crab at any point, however far it went
+    boolean ballHitsCrab(const size_t ball, const uint32_t crab) const {
+        const Vector2 from(balls.prevX[ball], balls.prevY[ball]);
+        const Vector2 pos = herds[Crab].pos(crab);
+        const Vector2 extent(static_cast<float>(ENTITY_HITBOX), static_cast<float>(ENTITY_HITBOX));
+        float toi;
+        return sweepBox(from, balls.pos(ball) - from, static_cast<float>(ENTITY_HITBOX), pos, pos + extent, toi);
+    }
+
+    // Balls whose path this step ran into a cliff go back to where they first touched it and
+    // leave off the face they hit, so nothing behind a cliff can be hit. The coast is the
+    // octopus' wall, it bats balls reaching it head on back faster than they came, and also
+    // any that found their way onto the water, e.g. past a cliff corner while arcing across rows.
+    void bounceBallsOffCliffs() {
+        for (size_t i = 0; i < balls.size(); ++i) {
+            const Vector2 from(balls.prevX[i], balls.prevY[i]);
+            const Vector2 delta = balls.pos(i) - from;
+            Vector2 pos = balls.pos(i);
+            Vector2 velocity = balls.velocity(i);
+
+            CliffContact contact;
+            const bool hit = sweepCliffs(from, delta, contact);
+            if (hit) {
+                pos = from + delta * contact.toi;
+                if (contact.axis == 0) {
+                    velocity.x *= contact.coast ? BALL_WALL_BOUNCE : BALL_CLIFF_BOUNCE;
                 }
-                else if (j < 20) {
-                    temp_rect = water_rect;
-                    descriptor = Water;
+                else {
+                    velocity.y *= BALL_CLIFF_BOUNCE;
                 }
-                this->tiles.push_back(new Tile{ 
-                    descriptor, Vector2(nx + j * TILE_SCALE, ny + i * TILE_SCALE), temp_rect 
-                });
+            }
+
+            const float wall = coastX(pos.y);
+            const bool batted = pos.x < wall;
+            if (batted) {
+                pos.x = wall;
+                velocity.x = velocity.x < 0.f ? velocity.x * BALL_WALL_BOUNCE : velocity.x;
+            }
+
+            if (hit || batted) {
+                balls.redirect(i, pos, velocity);
             }
         }
     }
 
-    void createBall(const Vector3 pos, const Vector2 vel) {
-        Projectile* ball = new Projectile(Ball, Vector2(pos.x, pos.y), vel);
-        projectiles.push_back(ball);
-    };
+    // World x where the water meets the cliff on the tile row holding y
+    float coastX(const float y) const {
+        const int row = tileRow(y);
+        return WORLD_ORIGIN_X + std::min(terrain.coastColumn(row), terrain.coastColumn(row - 1)) * TILE_SCALE;
+    }
 
-    void deleteBall() {
-        for (auto p : projectiles) {
-            delete p;
+    uint64_t crabsSpawned() const {
+        return spawner.spawnCount();
+    }
+
+    uint64_t crabsDespawned() const {
+        return spawner.despawnCount();
+    }
+
+    // Start of a simulation tick: everything that moves keeps its current position as the previous one
+    void snapshot() {
+        for (Herd& herd : herds) {
+            herd.snapshot();
         }
-        projectiles.clear();
+        balls.snapshot();
     }
 
-    void createAnimal(const Vector2 pos) {
-        Animal* an = new Animal(pos);
-        animals.push_back(an);
+    // One behavior call for the whole herd, no per-animal dispatch
+    void updateHerd(const Descriptors type, const TickContext& tick) {
+        if (HERD_BEHAVIORS[type] && !herds[type].empty()) {
+            HERD_BEHAVIORS[type](herds[type], tick);
+        }
     }
 
-    boolean checkForCollisions(const Vector3& newPos) const {
-        
-        for (auto& t : tiles) {
-            if (t->desc == Cliff && t->gapCheckVs(newPos)) {
-                return true;
+    // Crabs count toward the chunk they stand in, not the one they spawned in: one that has
+    // walked into another resident chunk moves its count there, one that has walked out of the window goes
+    void rehomeCrabs() {
+        Herd& crabs = herds[Crab];
+        for (size_t i = 0; i < crabs.size();) {
+            ChunkCoord* home = homeChunk.get(crabs.members[i]->id);
+            const ChunkCoord here = chunkAt(Vector3(crabs.x[i], crabs.y[i], 0.f));
+            if (home && *home != here) {
+                if (!chunks.find(here)) {
+                    releaseAnimal(crabs, i);
+                    continue;
+                }
+                spawner.moved(*home, here);
+                *home = here;
+            }
+            ++i;
+        }
+    }
+
+    // Despawn the crabs of chunks streamed out and populate the chunks streamed in
+    void settleChunks() {
+        for (const ChunkCoord coord : evictedChunks) {
+            despawnChunk(coord);
+        }
+        evictedChunks.clear();
+        for (const ChunkCoord coord : admittedChunks) {
+            if (const Chunk* chunk = chunks.find(coord)) {
+                populateChunk(*chunk);
             }
         }
+        admittedChunks.clear();
+    }
+
+    // Animal behind a handle, nullptr once it has been smushed and compacted away
+    Animal* findAnimal(const Entity e) const {
+        Animal* const* an = animalByEntity.get(e);
+        return an ? *an : nullptr;
+    }
+
+    // End of tick compaction: smushed animals go back to the pool and the last
+    // live one of their herd is swapped into their slot, so herds only ever hold the living
+    void compactAnimals() {
+        for (auto& herd : herds) {
+            for (size_t i = 0; i < herd.size();) {
+                if (herd.members[i]->alive) {
+                    ++i;
+                    continue;
+                }
+                releaseAnimal(herd, i);
+            }
+        }
+    }
+
+    uint32_t liveAnimals() const {
+        return animalPool.live();
+    }
+
+    uint32_t animalCapacity() const {
+        return animalPool.capacity();
+    }
+
+    // Cliff test on the solid bitmaps. A cliff's hitbox only covers the first
+    // CLIFF_HITBOX units of its cell, so only cells whose hitbox overlaps the
+    // player's are selected; that is at most one column and one row.
+    boolean checkForCollisions(const Vector3& newPos) const {
         
-        return false;
+        const TileRange cells{
+            tileColumn(newPos.x - CLIFF_HITBOX) + 1, tileColumnBefore(newPos.x + CLIFF_HITBOX),
+            tileRow(newPos.y - CLIFF_HITBOX) + 1, tileRowBefore(newPos.y + CLIFF_HITBOX)
+        };
+
+        return forEachChunkInCells(cells,
+            [](const Chunk& chunk, int c0, int c1, int r0, int r1) {
+                return chunk.layers[SolidLayer].any(c0, c1, r0, r1);
+            });
     }
 
     // Inclusive vector collision checker for tile based entities
     template <typename T>
     boolean checkForCollision(const T& newPos, const Vector2 pos) const {
-        int TILE_SCALE = 36;
-        if (pos.x < newPos.x + TILE_SCALE &&
-            pos.x + TILE_SCALE > newPos.x &&
-            pos.y < newPos.y + TILE_SCALE &&
-            pos.y + TILE_SCALE > newPos.y
+        if (pos.x < newPos.x + ENTITY_HITBOX &&
+            pos.x + ENTITY_HITBOX > newPos.x &&
+            pos.y < newPos.y + ENTITY_HITBOX &&
+            pos.y + ENTITY_HITBOX > newPos.y
             ) {
             return true;
         }
@@ -184,11 +545,112 @@ public:
     }
 
 private:
-    const RECT sand_rect = { 32, 32, 64, 64 };
+    struct CliffContact {
+        float toi;
+        int axis;   // of the face hit, 0 x or 1 y
+        bool coast; // the coastline rather than a rock
+    };
+
+    // Earliest contact of a ball moving from from by delta with a cliff hitbox, over every
+    // cell whose hitbox the swept ball box can reach. Cells the ball starts inside don't count,
+    // so a ball launched against a cliff can still leave it.
+    bool sweepCliffs(const Vector2 from, const Vector2 delta, CliffContact& contact) const {
+        const Vector2 to = from + delta;
+        const TileRange cells{
+            tileColumn(std::min(from.x, to.x) - CLIFF_HITBOX), tileColumnBefore(std::max(from.x, to.x) + ENTITY_HITBOX),
+            tileRow(std::min(from.y, to.y) - CLIFF_HITBOX), tileRowBefore(std::max(from.y, to.y) + ENTITY_HITBOX)
+        };
+        const Vector2 extent(static_cast<float>(CLIFF_HITBOX), static_cast<float>(CLIFF_HITBOX));
+
+        bool hit = false;
+        contact.toi = 1.f;
+        forEachChunkInCells(cells,
+            [&](const Chunk& chunk, int c0, int c1, int r0, int r1) {
+                const auto& solid = chunk.layers[SolidLayer];
+                if (!solid.any(c0, c1, r0, r1)) {
+                    return false;
+                }
+                for (int i = r0; i <= r1; ++i) {
+                    for (int j = c0; j <= c1; ++j) {
+                        if (!solid.test(j, i)) {
+                            continue;
+                        }
+                        const Vector2 anchor = tileAnchor(chunk.coord, j, i);
+                        float t;
+                        int axis;
+                        if (sweepBox(from, delta, static_cast<float>(ENTITY_HITBOX), anchor, anchor + extent, t, axis) &&
+                            axis >= 0 && t < contact.toi) {
+                            const int row = Chunk::globalRow(chunk.coord, i);
+                            contact.toi = t;
+                            contact.axis = axis;
+                            // the coast's cliff fills the step between its column on this row and the last
+                            contact.coast = Chunk::globalColumn(chunk.coord, j) <=
+                                std::max(terrain.coastColumn(row), terrain.coastColumn(row - 1));
+                            hit = true;
+                        }
+                    }
+                }
+                return false;
+            });
+        return hit;
+    }
 
-    const RECT water_rect = { 700, 0, 732, 32 };
+    int crabRoom() const {
+        return std::max(CRAB_BUDGET - static_cast<int>(herds[Crab].size()), 0);
+    }
+
+    // Spawner callback: a crab on a walkable tile of coord, unless it would land on the player
+    bool placeCrab(const ChunkCoord coord, const int column, const int row) {
+        const Vector2 pos = tileAnchor(coord, column, row);
+        const Vector2 player(lastCameraPos.x, lastCameraPos.y);
+        if ((pos - player).LengthSquared() < SPAWN_CLEARANCE * SPAWN_CLEARANCE) {
+            return false;
+        }
+        Animal* an = createAnimal(Crab, pos);
+        if (!an) {
+            return false;
+        }
+        homeChunk.add(an->id, coord);
+        return true;
+    }
+
+    // Fill a newly resident chunk up to its density target
+    void populateChunk(const Chunk& chunk) {
+        const int want = std::min(spawner.deficit(chunk.coord), crabRoom());
+        if (want > 0) {
+            spawner.populate(chunk, want, [this, &chunk](const int column, const int row) {
+                return placeCrab(chunk.coord, column, row);
+            });
+        }
+    }
 
-    const RECT shore_rect = { 876, 128, 912, 160 };
+    // Crabs homed in an evicted chunk go with it
+    void despawnChunk(const ChunkCoord coord) {
+        Herd& crabs = herds[Crab];
+        for (size_t i = 0; i < crabs.size();) {
+            const ChunkCoord* home = homeChunk.get(crabs.members[i]->id);
+            if (home && *home == coord) {
+                releaseAnimal(crabs, i);
+            }
+            else {
+                ++i;
+            }
+        }
+    }
+
+    // Return herd member i to the pool, the herd's last member takes its slot
+    void releaseAnimal(Herd& herd, const size_t i) {
+        Animal* an = herd.members[i];
+        if (const ChunkCoord* home = homeChunk.get(an->id)) {
+            spawner.removed(*home);
+            homeChunk.remove(an->id);
+        }
+        animalByEntity.remove(an->id);
+        entities.destroy(an->id);
+        animalPool.destroy(an);
+        herd.swapRemove(i);
+    }
 
-    const RECT ball_rect = { 0, 0, 16, 16 };
+    Vector3 lastCameraPos = Vector3(0.f, 0.f, 0.f);
+    ChunkCoord heading = { 0, 0 };
 };
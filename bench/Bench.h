@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+// Self-registering benchmarks: BENCH(name) { ... } in any file linked into bench.exe.
+// main runs them all, or only those whose name contains its first argument; each prints its own table.
+// Build Release: the numbers only mean anything optimized.
+struct BenchCase {
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<BenchCase>& benchCases() {
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+struct BenchRegistration {
+    BenchRegistration(const char* name, void (*run)()) {
+        benchCases().push_back(BenchCase{ name, run });
+    }
+};
+
+#define BENCH(name) \
+    static void name(); \
+    static const BenchRegistration name##Registration(#name, name); \
+    static void name()
+
+// Milliseconds one call of f takes, the best of repeats so a stray stall doesn't count
+template <typename F>
+double bestMs(const int repeats, const F& f) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = ms < best ? ms : best;
+    }
+    return best;
+}
+
+// Hands a result to the outside world so the optimizer can't drop the loop that made it
+inline void keep(const size_t value) {
+    static volatile size_t sink;
+    sink = sink + value;
+}
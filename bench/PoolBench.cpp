@@ -0,0 +1,202 @@
+#include "Bench.h"
+#include "World.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+
+// 100k crabs spawned at once, 90% of them smushed at an even rate over a 10 s session.
+// The world as built (pool, end of tick compaction) against the same herd with its animals
+// from new/delete, and against new/delete with the dead left in place, the way animals were
+// kept before compaction.
+
+namespace {
+
+    constexpr int CRABS = 100000;
+    constexpr int SESSION_TICKS = 600;
+    constexpr int DEATHS = CRABS / 10 * 9;
+    constexpr int DEATHS_PER_TICK = DEATHS / SESSION_TICKS;
+    constexpr int TICK_RATE = 60;
+
+    struct SpriteDraw {
+        Vector2 from;
+        Vector2 to;
+        RECT rect;
+    };
+
+    struct Stats {
+        double spawnMs;
+        double sessionMs;
+        double firstSecondMs;
+        double lastSecondMs;
+    };
+
+    Vector2 spot(const int i) {
+        return Vector2(static_cast<float>(i % 400) * 32.f, static_cast<float>(i / 400) * 32.f);
+    }
+
+    // the crabs in the order they die, the same for every variant
+    const std::vector<int>& deathOrder() {
+        static std::vector<int> order;
+        if (order.empty()) {
+            order.resize(CRABS);
+            for (int i = 0; i < CRABS; ++i) {
+                order[i] = i;
+            }
+            std::shuffle(order.begin(), order.end(), std::minstd_rand(7));
+            order.resize(DEATHS);
+        }
+        return order;
+    }
+
+    // What PublishFrame does with a herd each tick
+    template <bool SkipDead>
+    void drawHerd(const Herd& herd, std::vector<SpriteDraw>& sprites) {
+        sprites.clear();
+        for (size_t i = 0; i < herd.size(); ++i) {
+            if (SkipDead && !herd.members[i]->alive) {
+                continue;
+            }
+            sprites.push_back(SpriteDraw{ Vector2(herd.prevX[i], herd.prevY[i]), herd.pos(i), herd.members[i]->rect });
+        }
+    }
+
+    // Time spawn, then each tick of the session. tick(t) runs session tick t.
+    template <typename TSpawn, typename TTick>
+    Stats session(const TSpawn& spawn, const TTick& tick) {
+        typedef std::chrono::steady_clock Clock;
+        Stats stats = {};
+        Clock::time_point start = Clock::now();
+        spawn();
+        stats.spawnMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        for (int t = 0; t < SESSION_TICKS; ++t) {
+            start = Clock::now();
+            tick(t);
+            const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            stats.sessionMs += ms;
+            if (t < TICK_RATE) {
+                stats.firstSecondMs += ms / TICK_RATE;
+            }
+            if (t >= SESSION_TICKS - TICK_RATE) {
+                stats.lastSecondMs += ms / TICK_RATE;
+            }
+        }
+        return stats;
+    }
+
+    Stats worldSession(JobSystem& jobs) {
+        std::unique_ptr<World> world(new World(ChunkGeneration::Inline, CRABS + ANIMAL_CAPACITY));
+        std::vector<Animal*> crabs(CRABS);
+        std::vector<SpriteDraw> sprites;
+        sprites.reserve(CRABS + ANIMAL_CAPACITY);
+        const std::vector<int>& order = deathOrder();
+        return session(
+            [&] {
+                for (int i = 0; i < CRABS; ++i) {
+                    crabs[i] = world->createAnimal(Crab, spot(i));
+                }
+            },
+            [&](const int t) {
+                world->snapshot();
+                world->updateHerd(Crab, { 1.f / TICK_RATE, static_cast<float>(t) / TICK_RATE, false, Vector2(), 0.f, &jobs });
+                drawHerd<false>(world->herds[Crab], sprites);
+                for (int k = t * DEATHS_PER_TICK; k < (t + 1) * DEATHS_PER_TICK; ++k) {
+                    crabs[order[k]]->smush();
+                }
+                world->compactAnimals();
+            });
+    }
+
+    struct HeapAnimals {
+        Animal* create() {
+            return new Animal();
+        }
+
+        void destroy(Animal* an) {
+            delete an;
+        }
+    };
+
+    struct PooledAnimals {
+        Pool<Animal> pool{ CRABS };
+
+        Animal* create() {
+            return pool.create();
+        }
+
+        void destroy(Animal* an) {
+            pool.destroy(an);
+        }
+    };
+
+    // A bare herd: Compact returns the dead to TAnimals at the end of each tick like
+    // World::compactAnimals, otherwise they stay in the herd and drawing skips them
+    template <typename TAnimals, bool Compact>
+    Stats herdSession(JobSystem& jobs) {
+        std::unique_ptr<TAnimals> animals(new TAnimals());
+        Herd herd;
+        herd.reserve(CRABS);
+        std::vector<Animal*> crabs(CRABS);
+        std::vector<SpriteDraw> sprites;
+        sprites.reserve(CRABS);
+        const std::vector<int>& order = deathOrder();
+        const Stats stats = session(
+            [&] {
+                for (int i = 0; i < CRABS; ++i) {
+                    crabs[i] = animals->create();
+                    herd.push(crabs[i], spot(i));
+                }
+            },
+            [&](const int t) {
+                herd.snapshot();
+                crabBehavior(herd, { 1.f / TICK_RATE, static_cast<float>(t) / TICK_RATE, false, Vector2(), 0.f, &jobs });
+                drawHerd<!Compact>(herd, sprites);
+                for (int k = t * DEATHS_PER_TICK; k < (t + 1) * DEATHS_PER_TICK; ++k) {
+                    crabs[order[k]]->smush();
+                }
+                if (Compact) {
+                    for (size_t i = 0; i < herd.size();) {
+                        if (herd.members[i]->alive) {
+                            ++i;
+                            continue;
+                        }
+                        animals->destroy(herd.members[i]);
+                        herd.swapRemove(i);
+                    }
+                }
+            });
+        keep(sprites.size());
+        for (Animal* an : herd.members) {
+            animals->destroy(an);
+        }
+        return stats;
+    }
+
+    // Best of a few sessions by total time
+    template <typename TSession>
+    Stats best(const TSession& run) {
+        Stats fastest = run();
+        for (int i = 1; i < 3; ++i) {
+            const Stats stats = run();
+            if (stats.sessionMs < fastest.sessionMs) {
+                fastest = stats;
+            }
+        }
+        return fastest;
+    }
+
+    void report(const char* variant, const Stats& stats) {
+        std::printf("%-36s %9.2f %11.1f %13.3f %12.3f\n",
+            variant, stats.spawnMs, stats.sessionMs, stats.firstSecondMs, stats.lastSecondMs);
+    }
+
+}
+
+BENCH(CrabCompaction) {
+    JobSystem jobs;
+    std::printf("%d crabs, %d smushed over %d ticks\n", CRABS, DEATHS, SESSION_TICKS);
+    std::printf("%-36s %9s %11s %13s %12s\n", "", "spawn ms", "session ms", "first s ms/t", "last s ms/t");
+    report("world: pool, compacted", best([&] { return worldSession(jobs); }));
+    report("herd: pool, compacted", best([&] { return herdSession<PooledAnimals, true>(jobs); }));
+    report("herd: new/delete, compacted", best([&] { return herdSession<HeapAnimals, true>(jobs); }));
+    report("herd: new/delete, dead kept", best([&] { return herdSession<HeapAnimals, false>(jobs); }));
+}
@@ -0,0 +1,62 @@
+#include "Bench.h"
+#include "TileField.h"
+
+// Render and collision cost of the tile field at 10k, 100k and 1M resident tiles, for several
+// chunk sizes. The game keeps a 3x3 window of 40x20 chunks, about 7k tiles; the bigger fields
+// show how both paths scale if the window or the view ever grows.
+//
+// render:    PublishFrame's tile fill, every resident tile pushed as a TileDraw
+// collide:   checkForCollisions at random points across the field
+// scan:      countTilesUnder the whole field, the worst case a rect query can ask for
+
+namespace {
+
+    constexpr int QUERIES = 1000000;
+
+    template <int Width, int Height>
+    void measure(const int tiles) {
+        typedef Chunk<Width, Height> TChunk;
+        std::unique_ptr<Field<TChunk>> field(new Field<TChunk>(tiles));
+        const std::vector<Vector2> points = field->queryPoints(QUERIES);
+        std::vector<TileDraw> draws;
+        draws.reserve(field->tiles());
+
+        const double renderMs = bestMs(5, [&] {
+            field->render(draws);
+            keep(draws.size());
+        });
+        const double collideMs = bestMs(3, [&] {
+            size_t hits = 0;
+            for (const Vector2& point : points) {
+                hits += field->collides(point) ? 1 : 0;
+            }
+            keep(hits);
+        });
+        const double scanMs = bestMs(5, [&] {
+            keep(static_cast<size_t>(field->solidTiles()));
+        });
+
+        std::printf("%8d %5dx%-3d %9d %7.2f %10.3f %8.2f %12.1f %9.3f\n",
+            tiles, Width, Height, field->tiles(),
+            static_cast<double>(field->bytes()) / field->tiles(),
+            renderMs, renderMs * 1e6 / field->tiles(),
+            collideMs * 1e6 / QUERIES, scanMs);
+    }
+
+    template <int Width, int Height>
+    void measureSizes() {
+        measure<Width, Height>(10000);
+        measure<Width, Height>(100000);
+        measure<Width, Height>(1000000);
+    }
+
+}
+
+BENCH(TileField) {
+    std::printf("%8s %9s %9s %7s %10s %8s %12s %9s\n",
+        "field", "chunk", "resident", "B/tile", "render ms", "ns/tile", "collide ns/q", "scan ms");
+    measureSizes<16, 8>();
+    measureSizes<24, 12>();
+    measureSizes<CHUNK_WIDTH, CHUNK_HEIGHT>();
+    measureSizes<64, 32>();
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "World.h"
+#include <cmath>
+#include <random>
+
+// What PublishFrame records for each tile it draws
+struct TileDraw {
+    Vector2 pos;
+    const RECT* rect;
+};
+
+// A square field of at least tiles tiles, made of TChunk, generated inline around the origin.
+// Mirrors World's tile paths for a chunk size other than the game's.
+template <typename TChunk>
+class Field {
+public:
+    explicit Field(const int tiles) :
+        radiusX(radiusFor(tiles, TChunk::Columns)),
+        radiusY(radiusFor(tiles, TChunk::Rows)),
+        chunks(radiusX, radiusY,
+            [this](TChunk& chunk, const ChunkCoord coord) {
+                World::generateChunkAt(terrain, chunk, coord);
+            },
+            nullptr, nullptr, ChunkGeneration::Inline)
+    {
+        chunks.streamAround(ChunkCoord{ 0, 0 }, ChunkCoord{ 0, 0 });
+        cells = World::TileRange{
+            -radiusX * TChunk::Columns, (radiusX + 1) * TChunk::Columns - 1,
+            -radiusY * TChunk::Rows, (radiusY + 1) * TChunk::Rows - 1
+        };
+    }
+
+    int tiles() const {
+        return static_cast<int>(chunks.residentCount()) * TChunk::Tiles;
+    }
+
+    size_t bytes() const {
+        return chunks.residentBytes();
+    }
+
+    // World::forEachChunkInCells for TChunk
+    template <typename TVisit>
+    bool forEachChunkInCells(const World::TileRange& range, const TVisit& visit) const {
+        if (range.columnMin > range.columnMax || range.rowMin > range.rowMax) {
+            return false;
+        }
+        for (int cy = floorDiv(range.rowMin, TChunk::Rows); cy <= floorDiv(range.rowMax, TChunk::Rows); ++cy) {
+            for (int cx = floorDiv(range.columnMin, TChunk::Columns); cx <= floorDiv(range.columnMax, TChunk::Columns); ++cx) {
+                const TChunk* chunk = chunks.find(ChunkCoord{ cx, cy });
+                if (!chunk) {
+                    continue;
+                }
+                const int baseColumn = cx * TChunk::Columns;
+                const int baseRow = cy * TChunk::Rows;
+                if (visit(*chunk,
+                    std::max(range.columnMin - baseColumn, 0), std::min(range.columnMax - baseColumn, TChunk::Columns - 1),
+                    std::max(range.rowMin - baseRow, 0), std::min(range.rowMax - baseRow, TChunk::Rows - 1))) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    static Vector2 tileAnchor(const ChunkCoord coord, const int column, const int row) {
+        return Vector2(
+            WORLD_ORIGIN_X + TChunk::globalColumn(coord, column) * TILE_SCALE,
+            static_cast<float>(TChunk::globalRow(coord, row) * TILE_SCALE));
+    }
+
+    void render(std::vector<TileDraw>& draws) const {
+        draws.clear();
+        forEachChunkInCells(cells,
+            [&](const TChunk& chunk, int c0, int c1, int r0, int r1) {
+                for (int i = r0; i <= r1; ++i) {
+                    for (int j = c0; j <= c1; ++j) {
+                        draws.push_back(TileDraw{ tileAnchor(chunk.coord, j, i), &TILE_RECTS[chunk.type(TChunk::index(j, i))] });
+                    }
+                }
+                return false;
+            });
+    }
+
+    // visit(anchor, type) for every resident tile, chunk by chunk, in generation order
+    template <typename TVisit>
+    void forEachTile(const TVisit& visit) const {
+        forEachChunkInCells(cells,
+            [&](const TChunk& chunk, int c0, int c1, int r0, int r1) {
+                for (int i = r0; i <= r1; ++i) {
+                    for (int j = c0; j <= c1; ++j) {
+                        visit(tileAnchor(chunk.coord, j, i), chunk.type(TChunk::index(j, i)));
+                    }
+                }
+                return false;
+            });
+    }
+
+    // World::checkForCollisions
+    bool collides(const Vector2 pos) const {
+        const World::TileRange range{
+            World::tileColumn(pos.x - CLIFF_HITBOX) + 1, World::tileColumnBefore(pos.x + CLIFF_HITBOX),
+            World::tileRow(pos.y - CLIFF_HITBOX) + 1, World::tileRowBefore(pos.y + CLIFF_HITBOX)
+        };
+        return forEachChunkInCells(range,
+            [](const TChunk& chunk, int c0, int c1, int r0, int r1) {
+                return chunk.layers[SolidLayer].any(c0, c1, r0, r1);
+            });
+    }
+
+    int solidTiles() const {
+        int total = 0;
+        forEachChunkInCells(cells,
+            [&total](const TChunk& chunk, int c0, int c1, int r0, int r1) {
+                total += chunk.layers[SolidLayer].count(c0, c1, r0, r1);
+                return false;
+            });
+        return total;
+    }
+
+    // Query points spread uniformly over the field
+    std::vector<Vector2> queryPoints(const int count) const {
+        std::minstd_rand random(11);
+        std::uniform_real_distribution<float> across(
+            WORLD_ORIGIN_X + static_cast<float>(cells.columnMin * TILE_SCALE),
+            WORLD_ORIGIN_X + static_cast<float>((cells.columnMax + 1) * TILE_SCALE));
+        std::uniform_real_distribution<float> down(
+            static_cast<float>(cells.rowMin * TILE_SCALE), static_cast<float>((cells.rowMax + 1) * TILE_SCALE));
+        std::vector<Vector2> points(count);
+        for (Vector2& point : points) {
+            point.x = across(random);
+            point.y = down(random);
+        }
+        return points;
+    }
+
+private:
+    // chunks either side of the center to cover sqrt(tiles) cells along an axis of span cells per chunk
+    static int radiusFor(const int tiles, const int span) {
+        const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(tiles)) / span));
+        return side / 2;
+    }
+
+    const Terrain terrain{ WORLD_SEED };
+    int radiusX;
+    int radiusY;
+    ChunkManager<TChunk> chunks;
+    World::TileRange cells;
+};
@@ -0,0 +1,129 @@
+#include "Bench.h"
+#include "TileField.h"
+
+// The tile loops of a tick before and after tiles moved into chunk storage, at 10k, 100k and 1M tiles.
+//
+// before: a std::vector<Tile*>, every tile its own new Tile with a Descriptors, a Vector2 and a RECT.
+//         Rendering walks the list drawing tile->pos and tile->rect, and checkForCollisions tests
+//         every Cliff tile's hitbox against the player, as World did before the change.
+// after:  the game's 40x20 chunks, one byte per tile plus layer bitmaps. Rendering is PublishFrame's
+//         tile fill, and checkForCollisions reads the solid bitmaps of the cells the player can touch.
+//
+// Both sides are built from the same generated terrain, so they draw the same tiles and hit the
+// same cliffs. Old tiles are allocated back to back as generation made them, the kindest heap
+// layout they could get; a heap fragmented by a long session would only make "before" slower.
+
+namespace {
+
+    constexpr int AFTER_QUERIES = 1000000;
+    // the old scan touches every tile per query, so it gets fewer
+    constexpr int BEFORE_QUERIES = 200;
+
+    // World::Tile as it was
+    struct Tile {
+        Descriptors desc = Sand;
+        Vector2 pos = Vector2(0.f, 0.f);
+        RECT rect = RECT{ 0, 0, 0, 0 };
+
+        boolean gapCheckVs(const Vector2& newPos) const {
+            if (pos.x < newPos.x + CLIFF_HITBOX &&
+                pos.x + CLIFF_HITBOX > newPos.x &&
+                pos.y < newPos.y + CLIFF_HITBOX &&
+                pos.y + CLIFF_HITBOX > newPos.y) {
+                return true;
+            }
+            return false;
+        }
+    };
+
+    struct TileList {
+        std::vector<Tile*> tiles;
+
+        ~TileList() {
+            for (Tile* tile : tiles) {
+                delete tile;
+            }
+        }
+
+        void render(std::vector<TileDraw>& draws) const {
+            draws.clear();
+            for (const Tile* tile : tiles) {
+                draws.push_back(TileDraw{ tile->pos, &tile->rect });
+            }
+        }
+
+        bool collides(const Vector2 pos) const {
+            for (const Tile* tile : tiles) {
+                if (tile->desc == Cliff && tile->gapCheckVs(pos)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    struct Costs {
+        double renderMs;
+        double collideUs;
+        size_t hits;
+    };
+
+    template <typename TTiles>
+    Costs measure(const TTiles& tiles, const std::vector<Vector2>& points, const int queries, std::vector<TileDraw>& draws) {
+        Costs costs = {};
+        costs.renderMs = bestMs(5, [&] {
+            tiles.render(draws);
+            keep(draws.size());
+        });
+        costs.collideUs = bestMs(3, [&] {
+            size_t hits = 0;
+            for (int q = 0; q < queries; ++q) {
+                hits += tiles.collides(points[q]) ? 1 : 0;
+            }
+            costs.hits = hits;
+            keep(hits);
+        }) * 1000.0 / queries;
+        return costs;
+    }
+
+    void report(const char* variant, const int tiles, const double bytesPerTile, const Costs& costs) {
+        // a tick draws the field once and checks the player against the cliffs once
+        std::printf("%8d %-7s %7.1f %10.3f %12.3f %9.3f\n",
+            tiles, variant, bytesPerTile, costs.renderMs, costs.collideUs, costs.renderMs + costs.collideUs / 1000.0);
+    }
+
+    void compare(const int tiles) {
+        std::unique_ptr<Field<World::Chunk>> field(new Field<World::Chunk>(tiles));
+        TileList list;
+        list.tiles.reserve(field->tiles());
+        field->forEachTile([&](const Vector2 anchor, const Descriptors type) {
+            list.tiles.push_back(new Tile{ type, anchor, TILE_RECTS[type] });
+        });
+
+        const std::vector<Vector2> points = field->queryPoints(AFTER_QUERIES);
+        std::vector<TileDraw> draws;
+        draws.reserve(field->tiles());
+
+        const Costs before = measure(list, points, BEFORE_QUERIES, draws);
+        const Costs after = measure(*field, points, AFTER_QUERIES, draws);
+        const Costs check = measure(*field, points, BEFORE_QUERIES, draws);
+        if (check.hits != before.hits) {
+            std::printf("collision results differ: %zu before, %zu after\n", before.hits, check.hits);
+        }
+
+        // heap block headers not counted against "before"
+        report("before", field->tiles(), static_cast<double>(sizeof(Tile) + sizeof(Tile*)), before);
+        report("after", field->tiles(), static_cast<double>(field->bytes()) / field->tiles(), after);
+        std::printf("%8s %-7s %7s %9.1fx %11.0fx %8.1fx\n", "", "speedup", "",
+            before.renderMs / after.renderMs, before.collideUs / after.collideUs,
+            (before.renderMs + before.collideUs / 1000.0) / (after.renderMs + after.collideUs / 1000.0));
+    }
+
+}
+
+BENCH(TileStorage) {
+    std::printf("%8s %-7s %7s %10s %12s %9s\n", "tiles", "", "B/tile", "render ms", "collide us/q", "tick ms");
+    compare(10000);
+    compare(100000);
+    compare(1000000);
+}
@@ -0,0 +1,15 @@
+#include "Bench.h"
+#include <cstring>
+
+int main(int argc, char** argv) {
+    const char* only = argc > 1 ? argv[1] : nullptr;
+    for (const BenchCase& bench : benchCases()) {
+        if (only && !std::strstr(bench.name, only)) {
+            continue;
+        }
+        std::printf("== %s\n", bench.name);
+        bench.run();
+        std::printf("\n");
+    }
+    return 0;
+}
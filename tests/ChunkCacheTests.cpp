@@ -0,0 +1,256 @@
+#include "Test.h"
+#include "ChunkCache.h"
+#include <cstring>
+#include <map>
+#include <string>
+
+namespace {
+
+    typedef Chunk<8, 4> SmallChunk;
+
+    constexpr uint32_t SEED = 77;
+    constexpr uint32_t INDEX_SLOTS = CHUNK_CACHE_CAPACITY * 2;
+
+    const Descriptors TERRAIN[] = { Sand, Cliff, Water };
+
+    // Files kept in memory by path, so a cache can be closed and opened on the same bytes again
+    class MemoryFile {
+    public:
+        uint8_t* open(const wchar_t* path, const size_t bytes) {
+            std::vector<uint8_t>& file = files()[path];
+            file.resize(bytes);
+            return file.data();
+        }
+
+        void close() {}
+
+        static std::map<std::wstring, std::vector<uint8_t>>& files() {
+            static std::map<std::wstring, std::vector<uint8_t>> all;
+            return all;
+        }
+    };
+
+    typedef ChunkCache<SmallChunk, MemoryFile> Cache;
+
+    // A chunk whose bits all follow from its coordinate, mixed or uniform
+    void makeChunk(SmallChunk& chunk, const ChunkCoord coord, const bool uniform) {
+        chunk.coord = coord;
+        const uint32_t mix = hashCell(coord.x, coord.y);
+        for (int layer = 0; layer < LayerCount; ++layer) {
+            for (int row = 0; row < SmallChunk::Rows; ++row) {
+                chunk.layers[layer].rows[row] = (mix >> (layer + row)) & 0xff;
+            }
+        }
+        if (uniform) {
+            chunk.setUniform(TERRAIN[mix % 3]);
+            return;
+        }
+        SmallChunk::TileArray& tiles = chunk.tiles();
+        for (int k = 0; k < SmallChunk::Tiles; ++k) {
+            tiles[k] = static_cast<uint8_t>(TERRAIN[(mix + k) % 3]);
+        }
+    }
+
+    bool sameChunk(const SmallChunk& a, const SmallChunk& b) {
+        if (a.coord != b.coord || a.uniform() != b.uniform()) {
+            return false;
+        }
+        for (int layer = 0; layer < LayerCount; ++layer) {
+            if (a.layers[layer].rows != b.layers[layer].rows) {
+                return false;
+            }
+        }
+        for (int k = 0; k < SmallChunk::Tiles; ++k) {
+            if (a.type(k) != b.type(k)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool roundTrips(Cache& cache, const ChunkCoord coord, const bool uniform) {
+        SmallChunk expected;
+        makeChunk(expected, coord, uniform);
+        SmallChunk loaded;
+        return cache.load(loaded, coord) && sameChunk(loaded, expected);
+    }
+
+    int slotOf(const ChunkCoord coord) {
+        return static_cast<int>(hashCell(coord.x, coord.y) & (INDEX_SLOTS - 1));
+    }
+
+}
+
+TEST(ChunkCacheRoundTripsAcrossReopen) {
+    const ChunkCoord coords[] = { { 0, 0 }, { -1, 3 }, { 5, -7 }, { -300, -2 }, { 12, 40000 } };
+    {
+        Cache cache;
+        CHECK(cache.open(L"roundtrip", SEED));
+        for (int i = 0; i < 5; ++i) {
+            SmallChunk chunk;
+            makeChunk(chunk, coords[i], i % 2 == 1);
+            cache.store(chunk);
+        }
+        CHECK(cache.count() == 5);
+    }
+
+    Cache cache;
+    CHECK(cache.open(L"roundtrip", SEED));
+    CHECK(cache.count() == 5);
+    for (int i = 0; i < 5; ++i) {
+        CHECK(roundTrips(cache, coords[i], i % 2 == 1));
+    }
+
+    // a recycled chunk that held tiles takes a uniform record, and the other way round,
+    // keeping the tile array it already had
+    SmallChunk recycled;
+    makeChunk(recycled, { 9, 9 }, false);
+    const size_t before = heapAllocations();
+    CHECK(cache.load(recycled, coords[1]));
+    CHECK(recycled.uniform());
+    SmallChunk expected;
+    makeChunk(expected, coords[1], true);
+    CHECK(sameChunk(recycled, expected));
+    CHECK(cache.load(recycled, coords[0]));
+    CHECK(!recycled.uniform());
+    CHECK(heapAllocations() == before);
+
+    SmallChunk missing;
+    CHECK(!cache.load(missing, { 1, 1 }));
+}
+
+TEST(ChunkCacheStoresEachCoordinateOnce) {
+    Cache cache;
+    CHECK(cache.open(L"once", SEED));
+    SmallChunk chunk;
+    makeChunk(chunk, { 2, 2 }, false);
+    cache.store(chunk);
+    cache.store(chunk);
+    CHECK(cache.count() == 1);
+}
+
+TEST(ChunkCacheWipesOtherSeeds) {
+    {
+        Cache cache;
+        CHECK(cache.open(L"seeds", SEED));
+        SmallChunk chunk;
+        makeChunk(chunk, { 4, 4 }, false);
+        cache.store(chunk);
+    }
+    Cache cache;
+    CHECK(cache.open(L"seeds", SEED + 1));
+    CHECK(cache.count() == 0);
+    SmallChunk chunk;
+    CHECK(!cache.load(chunk, { 4, 4 }));
+}
+
+TEST(ChunkCacheProbesPastCollisions) {
+    // three coordinates sharing the index's last slot, so probing also wraps to slot 0
+    std::vector<ChunkCoord> colliding;
+    for (int y = 0; colliding.size() < 3; ++y) {
+        for (int x = -64; x < 64 && colliding.size() < 3; ++x) {
+            if (slotOf({ x, y }) == static_cast<int>(INDEX_SLOTS - 1)) {
+                colliding.push_back({ x, y });
+            }
+        }
+    }
+    // and the origin, which hashes to slot 0 where the wrapped entries now sit
+    const ChunkCoord first = { 0, 0 };
+    CHECK(slotOf(first) == 0);
+
+    Cache cache;
+    CHECK(cache.open(L"collisions", SEED));
+    for (const ChunkCoord coord : colliding) {
+        SmallChunk chunk;
+        makeChunk(chunk, coord, false);
+        cache.store(chunk);
+    }
+    SmallChunk chunk;
+    makeChunk(chunk, first, true);
+    cache.store(chunk);
+    CHECK(cache.count() == 4);
+
+    for (const ChunkCoord coord : colliding) {
+        CHECK(roundTrips(cache, coord, false));
+    }
+    CHECK(roundTrips(cache, first, true));
+}
+
+TEST(ChunkCacheStopsTakingChunksWhenFull) {
+    Cache cache;
+    CHECK(cache.open(L"full", SEED));
+    for (uint32_t i = 0; i < CHUNK_CACHE_CAPACITY; ++i) {
+        SmallChunk chunk;
+        makeChunk(chunk, { static_cast<int>(i % 64), static_cast<int>(i / 64) }, i % 3 == 0);
+        cache.store(chunk);
+    }
+    CHECK(cache.count() == CHUNK_CACHE_CAPACITY);
+
+    SmallChunk extra;
+    makeChunk(extra, { -1, -1 }, false);
+    cache.store(extra);
+    CHECK(cache.count() == CHUNK_CACHE_CAPACITY);
+    SmallChunk loaded;
+    CHECK(!cache.load(loaded, { -1, -1 }));
+
+    // everything stored before it is still there
+    for (uint32_t i = 0; i < CHUNK_CACHE_CAPACITY; i += 97) {
+        CHECK(roundTrips(cache, { static_cast<int>(i % 64), static_cast<int>(i / 64) }, i % 3 == 0));
+    }
+    CHECK(roundTrips(cache, { 63, 63 }, (CHUNK_CACHE_CAPACITY - 1) % 3 == 0));
+}
+
+TEST(ChunkCacheMissesWhenClosed) {
+    Cache cache;
+    SmallChunk chunk;
+    makeChunk(chunk, { 0, 0 }, false);
+    cache.store(chunk);
+    CHECK(!cache.isOpen());
+    CHECK(cache.count() == 0);
+    CHECK(!cache.load(chunk, { 0, 0 }));
+}
+
+TEST(ChunkCacheMissesDamagedRecords) {
+    // byte offsets of the file layout for SmallChunk, as a torn write would leave them
+    const size_t headerBytes = 8 * sizeof(uint32_t);
+    const size_t countAt = 6 * sizeof(uint32_t);
+    const size_t recordsAt = headerBytes + 3 * sizeof(uint32_t) * INDEX_SLOTS;
+    const size_t paletteAt = recordsAt + sizeof(uint64_t) * LayerCount * SmallChunk::Rows + 1;
+    const size_t tilesAt = paletteAt + 1;
+
+    const auto reopen = [](Cache& cache, const bool uniform, const size_t at, const uint8_t value) {
+        cache.close();
+        MemoryFile::files().erase(L"damaged");
+        CHECK(cache.open(L"damaged", SEED));
+        SmallChunk chunk;
+        makeChunk(chunk, { 3, 3 }, uniform);
+        cache.store(chunk);
+        CHECK(roundTrips(cache, { 3, 3 }, uniform));
+        cache.close();
+        MemoryFile::files()[L"damaged"][at] = value;
+        CHECK(cache.open(L"damaged", SEED));
+    };
+
+    Cache cache;
+    SmallChunk loaded;
+
+    // the index points at a record the header says was never finished
+    reopen(cache, false, countAt, 0);
+    CHECK(!cache.load(loaded, { 3, 3 }));
+
+    // a palette or tile byte past the last Descriptors
+    reopen(cache, true, paletteAt, static_cast<uint8_t>(Descriptors::Count));
+    CHECK(!cache.load(loaded, { 3, 3 }));
+    reopen(cache, false, tilesAt + SmallChunk::Tiles - 1, 0xff);
+    CHECK(!cache.load(loaded, { 3, 3 }));
+
+    // an index with no empty slot left, probing gives up instead of spinning
+    std::vector<uint8_t>& bytes = MemoryFile::files()[L"damaged"];
+    for (uint32_t slot = 0; slot < INDEX_SLOTS; ++slot) {
+        const int32_t entry[3] = { -1000, -1000, 1 };
+        std::memcpy(&bytes[headerBytes + sizeof(entry) * slot], entry, sizeof(entry));
+    }
+    CHECK(!cache.load(loaded, { 3, 3 }));
+    makeChunk(loaded, { 4, 4 }, false);
+    cache.store(loaded);
+}
@@ -0,0 +1,44 @@
+#include "Test.h"
+#include "World.h"
+#include <memory>
+
+namespace {
+
+    int crabsStandingIn(const World& world, const ChunkCoord coord) {
+        const Herd& crabs = world.herds[Crab];
+        int count = 0;
+        for (size_t i = 0; i < crabs.size(); ++i) {
+            if (World::chunkAt(Vector3(crabs.x[i], crabs.y[i], 0.f)) == coord) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+}
+
+TEST(CrabDensityHoldsAroundAStillCamera) {
+    JobSystem jobs(3);
+    std::unique_ptr<World> world(new World(ChunkGeneration::Inline));
+    const Vector3 camera(0.f, 0.f, 0.f);
+    const ChunkCoord here = World::chunkAt(camera);
+
+    // two minutes of crabs wobbling off the chunks they spawned in, with nothing smushed
+    int fewest = CRABS_PER_CHUNK;
+    bool booksMatch = true;
+    for (int tick = 1; tick <= 120 * 60; ++tick) {
+        world->snapshot();
+        world->streamChunks(camera);
+        world->updateHerd(Crab, { 1.f / 60, tick / 60.f, false, Vector2(), 0.f, &jobs });
+        world->compactAnimals();
+        world->rehomeCrabs();
+        world->settleChunks();
+        world->refillCrabs();
+
+        const int standing = crabsStandingIn(*world, here);
+        fewest = std::min(fewest, standing);
+        booksMatch = booksMatch && standing == world->spawner.population(here);
+    }
+    CHECK(booksMatch);
+    CHECK(fewest >= CRABS_PER_CHUNK - CRAB_REFILLS_PER_TICK);
+}
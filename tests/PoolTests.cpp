@@ -0,0 +1,96 @@
+#include "Test.h"
+#include "Pool.h"
+
+namespace {
+
+    constexpr uint32_t CAPACITY = 1024;
+
+    // Tracks its own lifetime so the test can see every create matched by a destroy
+    struct Critter {
+        static int alive;
+
+        uint32_t tag;
+        float x;
+        float y;
+
+        explicit Critter(const uint32_t tag) : tag(tag), x(0.f), y(0.f) {
+            ++alive;
+        }
+
+        ~Critter() {
+            --alive;
+        }
+    };
+
+    int Critter::alive = 0;
+
+}
+
+TEST(PoolChurnsWithoutAllocating) {
+    const size_t empty = heapAllocations();
+    Pool<Critter> pool(CAPACITY);
+    // the slab itself, in one allocation
+    CHECK(heapAllocations() == empty + 1);
+    Critter* live[CAPACITY];
+    uint32_t liveCount = 0;
+
+    // warm up by filling it once, noting where the slab lies
+    const char* lowest = nullptr;
+    const char* highest = nullptr;
+    for (uint32_t i = 0; i < CAPACITY; ++i) {
+        live[liveCount++] = pool.create(i);
+        const char* at = reinterpret_cast<const char*>(live[i]);
+        lowest = !lowest || at < lowest ? at : lowest;
+        highest = !highest || at > highest ? at : highest;
+    }
+    CHECK(pool.create(CAPACITY) == nullptr);
+
+    const size_t before = heapAllocations();
+    uint32_t state = 12345;
+    for (int round = 0; round < 200000; ++round) {
+        state = state * 1664525u + 1013904223u;
+        const bool spawn = liveCount == 0 || (liveCount < CAPACITY && (state >> 16) % 2 == 0);
+        if (spawn) {
+            Critter* critter = pool.create(static_cast<uint32_t>(round));
+            CHECK(critter != nullptr);
+            const char* at = reinterpret_cast<const char*>(critter);
+            CHECK(at >= lowest && at <= highest);
+            live[liveCount++] = critter;
+        }
+        else {
+            const uint32_t pick = (state >> 8) % liveCount;
+            pool.destroy(live[pick]);
+            live[pick] = live[--liveCount];
+        }
+        CHECK(pool.live() == liveCount);
+    }
+    CHECK(heapAllocations() == before);
+
+    // drain and refill to capacity again, still from the same slab
+    while (liveCount > 0) {
+        pool.destroy(live[--liveCount]);
+    }
+    CHECK(Critter::alive == 0);
+    for (uint32_t i = 0; i < CAPACITY; ++i) {
+        live[liveCount++] = pool.create(i);
+        CHECK(live[i] != nullptr);
+    }
+    CHECK(pool.create(CAPACITY) == nullptr);
+    CHECK(heapAllocations() == before);
+
+    // every object is distinct and kept its constructor argument
+    for (uint32_t i = 0; i < CAPACITY; ++i) {
+        CHECK(live[i]->tag == i);
+    }
+}
+
+TEST(PoolDestroysWhatIsLeftLive) {
+    {
+        Pool<Critter> pool(8);
+        pool.create(1u);
+        pool.destroy(pool.create(2u));
+        pool.create(3u);
+        CHECK(Critter::alive == 2);
+    }
+    CHECK(Critter::alive == 0);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+// Minimal self-registering tests: TEST(name) { CHECK(...); } in any file linked into tests.exe.
+// main runs them all and exits nonzero if any CHECK failed.
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<TestCase>& testCases() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+struct TestRegistration {
+    TestRegistration(const char* name, void (*run)()) {
+        testCases().push_back(TestCase{ name, run });
+    }
+};
+
+// Heap allocations made so far by the whole test binary, main.cpp counts them
+size_t heapAllocations();
+
+#define TEST(name) \
+    static void name(); \
+    static const TestRegistration name##Registration(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::printf("%s(%d): CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++testFailures(); \
+        } \
+    } while (false)
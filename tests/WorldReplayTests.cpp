@@ -0,0 +1,112 @@
+#include "Test.h"
+#include "PlayTick.h"
+#include "StepTimer.h"
+#include <cstring>
+#include <memory>
+
+namespace {
+
+    constexpr int REPLAY_TICKS = 1800;
+    constexpr int WINDOW_WIDTH = 1920;
+    constexpr int WINDOW_HEIGHT = 1080;
+    constexpr uint64_t TICK = DX::StepTimer::TicksPerSecond / 60;
+
+    // Fold the bytes of one value into an FNV-1a digest
+    template <typename T>
+    void mix(uint64_t& digest, const T& value) {
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        for (const unsigned char b : bytes) {
+            digest = (digest ^ b) * 1099511628211ull;
+        }
+    }
+
+    // Everything a tick can change that a replay must reproduce exactly
+    uint64_t digestOf(const PlaySession& play) {
+        const World& world = play.world;
+        uint64_t digest = 14695981039346656037ull;
+        for (const Herd& herd : world.herds) {
+            mix(digest, herd.size());
+            for (size_t i = 0; i < herd.size(); ++i) {
+                mix(digest, herd.x[i]);
+                mix(digest, herd.y[i]);
+            }
+        }
+        mix(digest, world.balls.size());
+        for (size_t i = 0; i < world.balls.size(); ++i) {
+            mix(digest, world.balls.x[i]);
+            mix(digest, world.balls.y[i]);
+            mix(digest, world.balls.vx[i]);
+            mix(digest, world.balls.vy[i]);
+        }
+        mix(digest, world.crabsSpawned());
+        mix(digest, world.crabsDespawned());
+        mix(digest, world.liveAnimals());
+        mix(digest, play.camera.x);
+        mix(digest, play.camera.y);
+        mix(digest, play.dog.hp);
+        mix(digest, play.score);
+        return digest;
+    }
+
+    // A scripted player: up the beach and east for half the run, then back down and west,
+    // throwing in bursts at a point that sweeps across the window
+    PlayTick inputFor(const int frame, const float elapsed, const float total) {
+        PlayTick tick = {};
+        tick.elapsed = elapsed;
+        tick.total = total;
+        tick.width = WINDOW_WIDTH;
+        tick.height = WINDOW_HEIGHT;
+        const bool out = frame < REPLAY_TICKS / 2;
+        tick.kb.Up = out;
+        tick.kb.Down = !out;
+        tick.kb.Left = out && frame % 3 == 0;
+        tick.kb.Right = !out && frame % 3 == 0;
+        tick.mouse.leftButton = (frame / 60) % 2 == 0;
+        tick.mouse.x = (frame * 37) % WINDOW_WIDTH;
+        tick.mouse.y = (frame * 23) % WINDOW_HEIGHT;
+        return tick;
+    }
+
+    // The game's play tick, every stage of it, on a virtual clock. Returns one digest per tick.
+    std::vector<uint64_t> replay(JobSystem& jobs) {
+        std::unique_ptr<World> world(new World(ChunkGeneration::Inline));
+        Dog dog;
+        Vector3 camera(START_POSITION);
+        int score = 0;
+        PlaySession play{ *world, dog, camera, score, jobs, {}, 0.f };
+        FrameGraph graph;
+        addPlayStages(graph, play);
+
+        DX::VirtualStepClock clock;
+        DX::StepTimer timer(clock);
+        timer.SetFixedTimeStep(true);
+        timer.SetTargetElapsedTicks(TICK);
+
+        std::vector<uint64_t> digests;
+        digests.reserve(REPLAY_TICKS);
+        while (static_cast<int>(timer.GetFrameCount()) < REPLAY_TICKS) {
+            clock.Advance(TICK);
+            timer.Tick([&] {
+                world->snapshot();
+                play.tick = inputFor(static_cast<int>(timer.GetFrameCount()),
+                    static_cast<float>(timer.GetElapsedSeconds()), static_cast<float>(timer.GetTotalSeconds()));
+                graph.run(jobs);
+                digests.push_back(digestOf(play));
+            });
+        }
+        return digests;
+    }
+
+}
+
+TEST(WorldReplaysInlineGenerationBitForBit) {
+    JobSystem jobs(3);
+    const std::vector<uint64_t> first = replay(jobs);
+    const std::vector<uint64_t> second = replay(jobs);
+    CHECK(first.size() == static_cast<size_t>(REPLAY_TICKS));
+    CHECK(second.size() == first.size());
+    for (size_t i = 0; i < first.size() && i < second.size(); ++i) {
+        CHECK(first[i] == second[i]);
+    }
+}
@@ -0,0 +1,48 @@
+#include "Test.h"
+#include <cstdlib>
+#include <new>
+
+// Every heap allocation in the test binary goes through here, so a test can count them
+static size_t allocations = 0;
+
+size_t heapAllocations() {
+    return allocations;
+}
+
+void* operator new(const size_t bytes) {
+    ++allocations;
+    if (void* p = std::malloc(bytes ? bytes : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void* operator new[](const size_t bytes) {
+    return operator new(bytes);
+}
+
+void operator delete[](void* p) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+int main() {
+    for (const TestCase& test : testCases()) {
+        const int before = testFailures();
+        test.run();
+        std::printf("%s %s\n", testFailures() == before ? "pass" : "FAIL", test.name);
+    }
+    std::printf("%d check(s) failed\n", testFailures());
+    return testFailures() == 0 ? 0 : 1;
+}